@@ -0,0 +1,661 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "Appender.h"
+#include "BatchEngine.h"
+#include "BulkOperations.h"
+#include "FileOperations.h"
+#include "FolderListing.h"
+#include "WatchedFolder.h"
+
+// benchmarks for the paths we lean on the most. every file system benchmark runs once in tmpfs (so it's mostly our
+// own overhead) and once on a real disk.
+//
+//	FileOperations_bench --benchmark_out=results.json --benchmark_out_format=json
+//
+// then compare two runs with google benchmark's tools/compare.py. FILEOPS_BENCH_TMPFS and FILEOPS_BENCH_DISK pick
+// where the trees get built (defaults are /dev/shm and a folder next to wherever you run it from).
+//
+// the "syscalls" counter needs perf to be allowed to use the raw_syscalls tracepoint (root, CAP_PERFMON, or a low
+// enough kernel.perf_event_paranoid, plus tracefs mounted). without it those benchmarks say "syscalls unavailable"
+// and only get the read/write counts.
+
+
+namespace
+{
+	struct Location
+	{
+		std::string name;
+		std::filesystem::path root;
+	};
+
+	std::vector<Location> locations()
+	{
+		std::vector<Location> found;
+
+		const char* tmpfs{ getenv("FILEOPS_BENCH_TMPFS") };
+		std::filesystem::path tmpfsRoot{ tmpfs ? tmpfs : "/dev/shm" };
+		if (std::filesystem::is_directory(tmpfsRoot)) {
+			found.push_back({ "tmpfs", tmpfsRoot / "FileOperations_bench" });
+		}
+
+		const char* disk{ getenv("FILEOPS_BENCH_DISK") };
+		found.push_back({ "disk", std::filesystem::path{ disk ? disk : "." } / "FileOperations_bench data" });
+
+		return found;
+	}
+
+	// every syscall this process makes, counted by the kernel's raw_syscalls:sys_enter tracepoint through perf. needs
+	// tracefs mounted and perf_event_paranoid (or CAP_PERFMON) to allow it. it gets opened once, before any benchmark
+	// starts a thread, and inherited by every thread after that. a thread's count gets added in when it exits, so
+	// anything that runs on a pool has to be done with it by the end of the iteration. -1 if it's not available
+	int syscallTracepoint()
+	{
+		static int fd{ [] {
+#ifdef __linux__
+			for (const char* tracefs : { "/sys/kernel/tracing", "/sys/kernel/debug/tracing" }) {
+				std::ifstream idFile{ std::format("{}/events/raw_syscalls/sys_enter/id", tracefs) };
+				unsigned long long id;
+				if (!(idFile >> id)) {
+					continue;
+				}
+
+				perf_event_attr attr{};
+				attr.type = PERF_TYPE_TRACEPOINT;
+				attr.size = sizeof(attr);
+				attr.config = id;
+				attr.inherit = 1;
+				return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+			}
+#endif
+			return -1;
+		}() };
+		return fd;
+	}
+
+	// syscalls this process has made so far. -1 for anything that's not available
+	struct SyscallCounts
+	{
+		// everything, from the tracepoint
+		long long total{ -1 };
+		// just the read and write class ones, from the kernel's per process io accounting. these work without perf
+		long long reads{ -1 };
+		long long writes{ -1 };
+	};
+
+	SyscallCounts syscallCounts()
+	{
+		SyscallCounts counts;
+		std::ifstream io{ "/proc/self/io" };
+		std::string key;
+		long long value;
+		while (io >> key >> value) {
+			if (key == "syscr:") counts.reads = value;
+			if (key == "syscw:") counts.writes = value;
+		}
+
+		// last, so reading /proc doesn't count
+		uint64_t total;
+#ifdef __linux__
+		if (syscallTracepoint() >= 0 && read(syscallTracepoint(), &total, sizeof(total)) == sizeof(total)) {
+			counts.total = static_cast<long long>(total);
+		}
+#endif
+		return counts;
+	}
+
+	// wrap the timed loop with this to get per iteration syscall counters in the output. the label says so when the
+	// total can't be counted here, so a missing "syscalls" column doesn't read as zero
+	class SyscallCounter
+	{
+	public:
+		explicit SyscallCounter(benchmark::State& state) : m_state{ state }, m_start{ syscallCounts() } {}
+
+		~SyscallCounter()
+		{
+			SyscallCounts end{ syscallCounts() };
+			if (m_start.total >= 0 && end.total >= 0) {
+				m_state.counters["syscalls"] = benchmark::Counter(static_cast<double>(end.total - m_start.total), benchmark::Counter::kAvgIterations);
+			}
+			else {
+				m_state.SetLabel("syscalls unavailable");
+			}
+			if (m_start.reads >= 0 && end.reads >= 0) {
+				m_state.counters["read_syscalls"] = benchmark::Counter(static_cast<double>(end.reads - m_start.reads), benchmark::Counter::kAvgIterations);
+				m_state.counters["write_syscalls"] = benchmark::Counter(static_cast<double>(end.writes - m_start.writes), benchmark::Counter::kAvgIterations);
+			}
+		}
+
+	private:
+		benchmark::State& m_state;
+		SyscallCounts m_start;
+	};
+
+	void makeFile(const std::filesystem::path& path, size_t size)
+	{
+		FileOpHelpers::createFolder(path);
+		std::ofstream f{ path, std::ios::binary };
+		std::string chunk(64 * 1024, 'x');
+		while (size > 0) {
+			size_t n{ std::min(size, chunk.size()) };
+			f.write(chunk.data(), static_cast<std::streamsize>(n));
+			size -= n;
+		}
+	}
+
+	// folder with fanOut files and fanOut sub folders, depth levels deep. only built once per run
+	std::filesystem::path tree(const Location& location, int fanOut, int depth, size_t fileSize)
+	{
+		static std::map<std::string, std::filesystem::path> built;
+
+		std::filesystem::path root{ location.root / std::format("tree {}x{} {}B", fanOut, depth, fileSize) };
+		if (built.contains(root.string())) {
+			return root;
+		}
+
+		std::filesystem::remove_all(root);
+		std::vector<std::filesystem::path> level{ root };
+		for (int d{ 0 }; d <= depth; d++) {
+			std::vector<std::filesystem::path> next;
+			for (const auto& folder : level) {
+				for (int i{ 0 }; i < fanOut; i++) {
+					makeFile(folder / std::format("file {}.txt", i), fileSize);
+					if (d < depth) {
+						next.push_back(folder / std::format("folder {}", i));
+					}
+				}
+			}
+			level = std::move(next);
+		}
+
+		built[root.string()] = root;
+		return root;
+	}
+
+	void getAllFilesInFolder(benchmark::State& state, const Location& location)
+	{
+		std::filesystem::path folder{ tree(location, static_cast<int>(state.range(0)), 0, 0) };
+
+		SyscallCounter counter{ state };
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(FileOperations::getAllFilesInFolder(folder));
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	// the same listing out of a WatchedFolder. what a repeat listing costs once it's warmed up
+	void watchedFolder(benchmark::State& state, const Location& location)
+	{
+		std::filesystem::path folder{ tree(location, static_cast<int>(state.range(0)), 0, 0) };
+		FileOperations::WatchedFolder watched{ folder };
+
+		SyscallCounter counter{ state };
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(watched.getAllFileNames(".txt"));
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	// the usual "list it, then sort by size" with directory_entries, vs the same thing with a FolderListing
+	void sortedBySize(benchmark::State& state, const Location& location)
+	{
+		std::filesystem::path folder{ tree(location, static_cast<int>(state.range(0)), 0, 0) };
+
+		SyscallCounter counter{ state };
+		for (auto _ : state) {
+			std::vector<std::filesystem::directory_entry> entries{ FileOperations::getAllFilesInFolder(folder) };
+			std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.file_size() < b.file_size(); });
+			benchmark::DoNotOptimize(entries);
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	void listFolderSortedBySize(benchmark::State& state, const Location& location)
+	{
+		std::filesystem::path folder{ tree(location, static_cast<int>(state.range(0)), 0, 0) };
+
+		SyscallCounter counter{ state };
+		for (auto _ : state) {
+			FileOperations::FolderListing listing{ FileOperations::listFolder(folder) };
+			listing.sort(FileOperations::FolderListing::SortBy::Size);
+			benchmark::DoNotOptimize(listing);
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	void getAllFilesInFolderRecursive(benchmark::State& state, const Location& location)
+	{
+		std::filesystem::path folder{ tree(location, static_cast<int>(state.range(0)), 2, 0) };
+
+		SyscallCounter counter{ state };
+		size_t files{ 0 };
+		for (auto _ : state) {
+			files = FileOperations::getAllFilesInFolderRecursive(folder).size();
+		}
+		state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(files));
+	}
+
+	// range(0) is how many names in the family are already taken
+	void getFirstUnusedFileName(benchmark::State& state, const Location& location)
+	{
+		std::filesystem::path folder{ location.root / std::format("collisions {}", state.range(0)) };
+		std::filesystem::remove_all(folder);
+		for (int64_t n{ 1 }; n <= state.range(0); n++) {
+			makeFile(n == 1 ? folder / "name.txt" : folder / std::format("name ({}).txt", n), 0);
+		}
+
+		SyscallCounter counter{ state };
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(FileOpHelpers::getFirstUnusedFileName(folder / "name.txt"));
+		}
+	}
+
+	// range(0) files across 16 folders, each renamed back and forth. one at a time, or as one bulk plan
+	void renameMany(benchmark::State& state, const Location& location, bool bulk)
+	{
+		std::filesystem::path folder{ location.root / "renaming" };
+		std::filesystem::remove_all(folder);
+		std::vector<FileOperations::BulkOperation> there;
+		std::vector<FileOperations::BulkOperation> back;
+		for (int64_t i{ 0 }; i < state.range(0); i++) {
+			std::filesystem::path sub{ folder / std::to_string(i % 16) };
+			makeFile(sub / std::format("a{}.txt", i), 0);
+			there.push_back({ FileOperations::BulkAction::Rename, sub / std::format("a{}.txt", i), std::format("b{}", i) });
+			back.push_back({ FileOperations::BulkAction::Rename, sub / std::format("b{}.txt", i), std::format("a{}", i) });
+		}
+
+		SyscallCounter counter{ state };
+		for (auto _ : state) {
+			for (const auto* plan : { &there, &back }) {
+				if (bulk) {
+					benchmark::DoNotOptimize(FileOperations::runBulkOperations(*plan));
+				}
+				else {
+					for (const FileOperations::BulkOperation& operation : *plan) {
+						FileOperations::renameFile(operation.path, operation.newName);
+					}
+				}
+			}
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0) * 2);
+	}
+
+	void copyFile(benchmark::State& state, const Location& location)
+	{
+		std::filesystem::path folder{ location.root / "copying" };
+		std::filesystem::remove_all(folder);
+		std::filesystem::path source{ folder / std::format("source {}.bin", state.range(0)) };
+		makeFile(source, static_cast<size_t>(state.range(0)));
+
+		SyscallCounter counter{ state };
+		for (auto _ : state) {
+			FileOperations::CopyResult result{ FileOperations::copyFile(source) };
+
+			state.PauseTiming();
+			std::filesystem::remove(result.destination);
+			state.ResumeTiming();
+		}
+		state.SetBytesProcessed(state.iterations() * state.range(0));
+	}
+
+	// range(0) small files, each replaced every iteration. one writeStringToFile() at a time, or all through a
+	// BatchEngine (on io_uring, or forced onto its thread pool)
+	void writeManyFiles(benchmark::State& state, const Location& location, bool batched, bool useIoUring)
+	{
+		std::filesystem::path folder{ location.root / "batch writing" };
+		std::filesystem::remove_all(folder);
+		std::vector<std::filesystem::path> files;
+		for (int64_t i{ 0 }; i < state.range(0); i++) {
+			files.push_back(folder / std::to_string(i % 16) / std::format("file {}.txt", i));
+		}
+		const std::string contents(200, 'x');
+
+		FileOperations::BatchOptions options;
+		options.useIoUring = useIoUring;
+		FileOperations::BatchEngine batch{ options };
+
+		SyscallCounter counter{ state };
+		for (auto _ : state) {
+			if (!batched) {
+				for (const std::filesystem::path& file : files) {
+					FileOperations::writeStringToFile(contents, file);
+				}
+			}
+			else {
+				for (const std::filesystem::path& file : files) {
+					batch.submitWrite(file, contents);
+				}
+				benchmark::DoNotOptimize(batch.run());
+			}
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	// range(0) copies of small files. the copies get deleted again outside of the timing
+	void copyManyFiles(benchmark::State& state, const Location& location, bool batched)
+	{
+		std::filesystem::path folder{ location.root / "batch copying" };
+		std::filesystem::remove_all(folder);
+		std::vector<std::filesystem::path> sources;
+		for (int64_t i{ 0 }; i < state.range(0); i++) {
+			sources.push_back(folder / std::to_string(i % 16) / std::format("file {}.txt", i));
+			makeFile(sources.back(), 4 << 10);
+		}
+
+		FileOperations::BatchEngine batch;
+		std::vector<std::filesystem::path> copies;
+
+		SyscallCounter counter{ state };
+		for (auto _ : state) {
+			copies.clear();
+			if (!batched) {
+				for (const std::filesystem::path& source : sources) {
+					copies.push_back(FileOperations::copyFile(source).destination);
+				}
+			}
+			else {
+				for (const std::filesystem::path& source : sources) {
+					batch.submitCopy(source);
+				}
+				for (const FileOperations::BatchCompletion& done : batch.run()) {
+					copies.push_back(done.path);
+				}
+			}
+
+			state.PauseTiming();
+			for (const std::filesystem::path& copy : copies) {
+				std::filesystem::remove(copy);
+			}
+			state.ResumeTiming();
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	void readFile(benchmark::State& state, const Location& location)
+	{
+		std::filesystem::path file{ location.root / std::format("reading/{}.bin", state.range(0)) };
+		makeFile(file, static_cast<size_t>(state.range(0)));
+
+		SyscallCounter counter{ state };
+		for (auto _ : state) {
+			FileOperations::FileContents contents{ FileOperations::readFile(file) };
+			// touch every page, otherwise a mapped read costs nothing
+			size_t sum{ 0 };
+			for (size_t i{ 0 }; i < contents.size(); i += 4096) {
+				sum += static_cast<unsigned char>(contents.view()[i]);
+			}
+			benchmark::DoNotOptimize(sum);
+		}
+		state.SetBytesProcessed(state.iterations() * state.range(0));
+	}
+
+	void writeStringsToFile(benchmark::State& state, const Location& location)
+	{
+		std::filesystem::path file{ location.root / "writing/lines.txt" };
+		std::vector<std::string> lines(static_cast<size_t>(state.range(0)), "a line that's about as long as a log line");
+
+		size_t bytes{ 0 };
+		for (const std::string& line : lines) {
+			bytes += line.size() + 1;
+		}
+
+		SyscallCounter counter{ state };
+		for (auto _ : state) {
+			FileOperations::writeStringsToFile(lines, file);
+		}
+		state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(bytes));
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	// one big blob, written normally (0), through the page cache but dropped behind (1), or with O_DIRECT (2)
+	void writeLargeFile(benchmark::State& state, const Location& location)
+	{
+		std::filesystem::path file{ location.root / "writing/large.bin" };
+		std::string blob(256 << 20, 'x');
+
+		FileOperations::LargeWriteOptions options;
+		options.expectedSize = blob.size() + 1;
+		options.direct = state.range(0) == 2;
+
+		SyscallCounter counter{ state };
+		for (auto _ : state) {
+			if (state.range(0) == 0) {
+				FileOperations::writeStringToFile(blob, file);
+			}
+			else {
+				FileOperations::writeStringToFile(blob, file, options);
+			}
+		}
+		state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(blob.size()));
+	}
+
+	// range(0) log lines, appended one writeStringToFile(..., app) at a time, or through an Appender (flushed at the end
+	// of every iteration, so it's all on disk either way)
+	void appendLines(benchmark::State& state, const Location& location, bool appender)
+	{
+		std::filesystem::path file{ location.root / "appending/log.txt" };
+		std::filesystem::remove(file);
+		const std::string line{ "a line that's about as long as a log line" };
+
+		SyscallCounter counter{ state };
+		if (appender) {
+			FileOperations::Appender log{ file };
+			for (auto _ : state) {
+				for (int64_t i{ 0 }; i < state.range(0); i++) {
+					log.append(line);
+				}
+				log.flush();
+			}
+		}
+		else {
+			for (auto _ : state) {
+				for (int64_t i{ 0 }; i < state.range(0); i++) {
+					FileOperations::writeStringToFile(line + '\n', file, std::ios_base::app);
+				}
+			}
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	// one small file replaced atomically, at each Durability (range(0))
+	void writeAtomically(benchmark::State& state, const Location& location)
+	{
+		std::filesystem::path file{ location.root / "writing/atomic.txt" };
+		const std::string contents(4 << 10, 'x');
+
+		FileOperations::AtomicWriteOptions options;
+		options.durability = static_cast<FileOperations::Durability>(state.range(0));
+
+		SyscallCounter counter{ state };
+		for (auto _ : state) {
+			FileOperations::writeStringToFileAtomic(contents, file, options);
+		}
+		state.SetItemsProcessed(state.iterations());
+	}
+
+	// the failure paths: reading, renaming, and copying a file that isn't there, through the throwing overloads and
+	// the error_code ones
+	void missingFile(benchmark::State& state, const Location& location, bool throwing)
+	{
+		std::filesystem::path missing{ location.root / "missing/not here.txt" };
+		FileOpHelpers::createFolder(missing.parent_path());
+
+		SyscallCounter counter{ state };
+		for (auto _ : state) {
+			if (throwing) {
+				try {
+					benchmark::DoNotOptimize(FileOperations::readFile(missing));
+				}
+				catch (const std::filesystem::filesystem_error&) {
+				}
+				try {
+					benchmark::DoNotOptimize(FileOperations::renameFile(missing, "still not here"));
+				}
+				catch (const std::filesystem::filesystem_error&) {
+				}
+				try {
+					benchmark::DoNotOptimize(FileOperations::copyFile(missing));
+				}
+				catch (const std::filesystem::filesystem_error&) {
+				}
+			}
+			else {
+				std::error_code ec;
+				benchmark::DoNotOptimize(FileOperations::readFile(missing, ec));
+				benchmark::DoNotOptimize(FileOperations::renameFile(missing, "still not here", ec));
+				benchmark::DoNotOptimize(FileOperations::copyFile(missing, ec));
+			}
+		}
+		state.SetItemsProcessed(state.iterations() * 3);
+	}
+
+	// rows that have to be formatted first. the vector version has to build every line as its own string before it
+	// can write any of them
+	struct Row
+	{
+		int64_t id;
+		double value;
+	};
+
+	void writeFormattedRows(benchmark::State& state, const Location& location, bool range)
+	{
+		std::filesystem::path file{ location.root / "writing/rows.csv" };
+		std::vector<Row> rows(static_cast<size_t>(state.range(0)));
+		for (size_t i{ 0 }; i < rows.size(); i++) {
+			rows[i] = { static_cast<int64_t>(i), static_cast<double>(i) / 3 };
+		}
+
+		SyscallCounter counter{ state };
+		for (auto _ : state) {
+			if (range) {
+				FileOperations::writeStringsToFile(rows, [](auto out, const Row& row) {
+					return std::format_to(out, "{},{:.3f}", row.id, row.value);
+				}, file);
+			}
+			else {
+				std::vector<std::string> lines;
+				lines.reserve(rows.size());
+				for (const Row& row : rows) {
+					lines.push_back(std::format("{},{:.3f}", row.id, row.value));
+				}
+				FileOperations::writeStringsToFile(lines, file);
+			}
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	void unSuffix(benchmark::State& state)
+	{
+		std::vector<std::string> paths{ "some folder/file.txt", "some folder/file (2).txt", "some folder/file (123456).txt", "file(2)", "a (b).txt" };
+
+		for (auto _ : state) {
+			for (const std::string& path : paths) {
+				benchmark::DoNotOptimize(FileOpHelpers::unSuffix(path));
+			}
+		}
+		state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(paths.size()));
+	}
+
+	void filenameHasIllegalChar(benchmark::State& state)
+	{
+		std::vector<std::string> names(1000);
+		for (size_t i{ 0 }; i < names.size(); i++) {
+			names[i] = std::format("a pretty normal user supplied file name {}.txt", i);
+		}
+
+		for (auto _ : state) {
+			for (const std::string& name : names) {
+				benchmark::DoNotOptimize(FileOpHelpers::filenameHasIllegalChar(name));
+			}
+		}
+		state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(names.size()));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+		return 1;
+	}
+
+	// before any threads, so they all inherit it
+	syscallTracepoint();
+
+	std::vector<Location> where{ locations() };
+	for (const Location& location : where) {
+		std::string suffix{ "/" + location.name };
+
+		benchmark::RegisterBenchmark(("getAllFilesInFolder" + suffix).c_str(), getAllFilesInFolder, location)
+			->Arg(10)->Arg(1'000)->Arg(10'000);
+		benchmark::RegisterBenchmark(("watchedFolder" + suffix).c_str(), watchedFolder, location)
+			->Arg(10)->Arg(1'000)->Arg(10'000);
+		benchmark::RegisterBenchmark(("sortedBySize" + suffix).c_str(), sortedBySize, location)
+			->Arg(1'000)->Arg(100'000)->UseRealTime();
+		benchmark::RegisterBenchmark(("listFolderSortedBySize" + suffix).c_str(), listFolderSortedBySize, location)
+			->Arg(1'000)->Arg(100'000)->UseRealTime();
+		benchmark::RegisterBenchmark(("getAllFilesInFolderRecursive" + suffix).c_str(), getAllFilesInFolderRecursive, location)
+			->Arg(4)->Arg(16)->Arg(32)->UseRealTime();
+		benchmark::RegisterBenchmark(("getFirstUnusedFileName" + suffix).c_str(), getFirstUnusedFileName, location)
+			->Arg(0)->Arg(1)->Arg(10)->Arg(100)->Arg(1'000);
+		benchmark::RegisterBenchmark(("renameMany/sequential" + suffix).c_str(), renameMany, location, false)
+			->Arg(10'000)->UseRealTime();
+		benchmark::RegisterBenchmark(("renameMany/bulk" + suffix).c_str(), renameMany, location, true)
+			->Arg(10'000)->UseRealTime();
+		benchmark::RegisterBenchmark(("copyFile" + suffix).c_str(), copyFile, location)
+			->Arg(4 << 10)->Arg(64 << 10)->Arg(1 << 20)->Arg(16 << 20);
+		benchmark::RegisterBenchmark(("writeManyFiles/loop" + suffix).c_str(), writeManyFiles, location, false, false)
+			->Arg(100)->Arg(10'000)->UseRealTime();
+		benchmark::RegisterBenchmark(("writeManyFiles/batch" + suffix).c_str(), writeManyFiles, location, true, true)
+			->Arg(100)->Arg(10'000)->UseRealTime();
+		benchmark::RegisterBenchmark(("writeManyFiles/pool" + suffix).c_str(), writeManyFiles, location, true, false)
+			->Arg(100)->Arg(10'000)->UseRealTime();
+		benchmark::RegisterBenchmark(("copyManyFiles/loop" + suffix).c_str(), copyManyFiles, location, false)
+			->Arg(100)->Arg(10'000)->UseRealTime();
+		benchmark::RegisterBenchmark(("copyManyFiles/batch" + suffix).c_str(), copyManyFiles, location, true)
+			->Arg(100)->Arg(10'000)->UseRealTime();
+		benchmark::RegisterBenchmark(("readFile" + suffix).c_str(), readFile, location)
+			->Arg(4 << 10)->Arg(1 << 20)->Arg(64 << 20);
+		benchmark::RegisterBenchmark(("writeStringsToFile" + suffix).c_str(), writeStringsToFile, location)
+			->Arg(1)->Arg(100)->Arg(10'000)->Arg(1'000'000);
+		benchmark::RegisterBenchmark(("writeLargeFile" + suffix).c_str(), writeLargeFile, location)
+			->Arg(0)->Arg(1)->Arg(2)->UseRealTime();
+		benchmark::RegisterBenchmark(("appendLines/loop" + suffix).c_str(), appendLines, location, false)
+			->Arg(1'000)->UseRealTime();
+		benchmark::RegisterBenchmark(("appendLines/appender" + suffix).c_str(), appendLines, location, true)
+			->Arg(1'000)->UseRealTime();
+		benchmark::RegisterBenchmark(("writeAtomically" + suffix).c_str(), writeAtomically, location)
+			->Arg(0)->Arg(1)->Arg(2)->UseRealTime();
+		benchmark::RegisterBenchmark(("missingFile/throwing" + suffix).c_str(), missingFile, location, true);
+		benchmark::RegisterBenchmark(("missingFile/error_code" + suffix).c_str(), missingFile, location, false);
+		benchmark::RegisterBenchmark(("writeFormattedRows/vector" + suffix).c_str(), writeFormattedRows, location, false)
+			->Arg(10'000)->Arg(1'000'000);
+		benchmark::RegisterBenchmark(("writeFormattedRows/range" + suffix).c_str(), writeFormattedRows, location, true)
+			->Arg(10'000)->Arg(1'000'000);
+	}
+	benchmark::RegisterBenchmark("unSuffix", unSuffix);
+	benchmark::RegisterBenchmark("filenameHasIllegalChar", filenameHasIllegalChar);
+
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+
+	for (const Location& location : where) {
+		std::error_code ec;
+		std::filesystem::remove_all(location.root, ec);
+	}
+	return 0;
+}
@@ -1,6 +1,24 @@
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <ranges>
+#include <set>
+#include <thread>
+
+#include "Appender.h"
+#include "BatchEngine.h"
+#include "BulkOperations.h"
+#include "Duplicates.h"
 #include "FileOperations.h"
+#include "Folder.h"
+#include "FolderListing.h"
+#include "Simd.h"
+#include "Stats.h"
+#include "ThreadPool.h"
+#include "WatchedFolder.h"
 
 
 void decomposeFileSystemPath(const std::filesystem::path& path)
@@ -49,6 +67,55 @@ TEST(FileOpHelperTests, IllegalFileNames)
 	ASSERT_EQ(FileOpHelpers::filenameHasIllegalChar("te><t.txt"), '>');
 }
 
+TEST(FileOpHelperTests, CheckingFileNames)
+{
+	using FileOpHelpers::NameProblem;
+	using FileOpHelpers::NameRules;
+
+	ASSERT_EQ(FileOpHelpers::checkFileName("text.txt"), NameProblem::None);
+	ASSERT_EQ(FileOpHelpers::checkFileName(""), NameProblem::Empty);
+	ASSERT_EQ(FileOpHelpers::checkFileName(".."), NameProblem::ReservedName);
+	ASSERT_EQ(FileOpHelpers::checkFileName("te?xt.txt"), NameProblem::IllegalChar);
+	ASSERT_EQ(FileOpHelpers::checkFileName("tab\there"), NameProblem::IllegalChar);
+	ASSERT_EQ(FileOpHelpers::checkFileName("CON"), NameProblem::ReservedName);
+	ASSERT_EQ(FileOpHelpers::checkFileName("nul.txt"), NameProblem::ReservedName);
+	ASSERT_EQ(FileOpHelpers::checkFileName("Com7 .log"), NameProblem::ReservedName);
+	ASSERT_EQ(FileOpHelpers::checkFileName("console.txt"), NameProblem::None);
+	ASSERT_EQ(FileOpHelpers::checkFileName("COM0"), NameProblem::None);
+	ASSERT_EQ(FileOpHelpers::checkFileName("file."), NameProblem::TrailingDotOrSpace);
+	ASSERT_EQ(FileOpHelpers::checkFileName("file "), NameProblem::TrailingDotOrSpace);
+
+	// posix only cares about '/'
+	ASSERT_EQ(FileOpHelpers::checkFileName("what?.txt", NameRules::Posix), NameProblem::None);
+	ASSERT_EQ(FileOpHelpers::checkFileName("CON.", NameRules::Posix), NameProblem::None);
+	ASSERT_EQ(FileOpHelpers::checkFileName("a/b", NameRules::Posix), NameProblem::IllegalChar);
+	ASSERT_EQ(FileOpHelpers::checkFileName(".", NameRules::Posix), NameProblem::ReservedName);
+
+	// portable doesn't even like spaces
+	ASSERT_EQ(FileOpHelpers::checkFileName("my-file_2.txt", NameRules::Portable), NameProblem::None);
+	ASSERT_EQ(FileOpHelpers::checkFileName("my file.txt", NameRules::Portable), NameProblem::IllegalChar);
+	ASSERT_EQ(FileOpHelpers::checkFileName("caf\xc3\xa9.txt", NameRules::Portable), NameProblem::IllegalChar);
+	ASSERT_EQ(FileOpHelpers::checkFileName("aux", NameRules::Portable), NameProblem::ReservedName);
+
+	// in bulk
+	std::vector<std::string> names{ "ok.txt", "bad|.txt", "LPT1", "fine" };
+	std::vector<NameProblem> results(names.size());
+	ASSERT_EQ(FileOpHelpers::checkFileNames(names, results), 2);
+	ASSERT_EQ(results, (std::vector<NameProblem>{ NameProblem::None, NameProblem::IllegalChar, NameProblem::ReservedName, NameProblem::None }));
+
+	// fixing them up in place
+	std::vector<std::string> fixes{ "ok.txt", "bad|.txt", "CON.txt", "trailing. ", "", "..", "a b" };
+	ASSERT_EQ(FileOpHelpers::sanitizeFileNames(fixes), 5);
+	ASSERT_EQ(fixes, (std::vector<std::string>{ "ok.txt", "bad_.txt", "CON_.txt", "trailing__", "_", "__", "a b" }));
+	for (const std::string& name : fixes) {
+		ASSERT_EQ(FileOpHelpers::checkFileName(name), NameProblem::None);
+	}
+
+	std::string portable{ "my file?.txt" };
+	ASSERT_TRUE(FileOpHelpers::sanitizeFileName(portable, NameRules::Portable, '-'));
+	ASSERT_EQ(portable, "my-file-.txt");
+}
+
 TEST(FileOpHelperTests, Unsuffix)
 {
 	ASSERT_EQ(FileOpHelpers::unSuffix("/test/message (2).txt"), "/test/message.txt");
@@ -77,8 +144,52 @@ TEST(FileOpHelperTests, Unsuffix)
 	// test files that are just spaces and (n+). these result in blank files names, so it should abort
 	ASSERT_EQ(FileOpHelpers::unSuffix("    (2345)            "), "    (2345)            ");
 	ASSERT_EQ(FileOpHelpers::unSuffix("           (4789)"), "           (4789)");
-	//ASSERT_EQ(FileOpHelpers::unSuffix("(5453)            "), "(5453)            ");
-	// TODO this last one doesn't work correctly, but i'm not going to worry about it for now.
+	ASSERT_EQ(FileOpHelpers::unSuffix("(5453)            "), "(5453)            ");
+}
+
+// the buffer versions are constexpr, so the suffix rules get checked by the compiler too
+static_assert(FileOpHelpers::splitSuffix("/test/message (2).txt").head == "/test/message");
+static_assert(FileOpHelpers::splitSuffix("/test/message (2).txt").tail == ".txt");
+static_assert(FileOpHelpers::splitSuffix("/test/message (2).txt").digits == "2");
+static_assert(!FileOpHelpers::splitSuffix("/test/message (37)  d .txt").found);
+static_assert(!FileOpHelpers::splitSuffix("(5453)            ").found);
+static_assert(FileOpHelpers::extensionOf("folder.d/archive.tar.gz") == ".gz");
+static_assert(FileOpHelpers::extensionOf("folder.d/.bashrc").empty());
+static_assert(FileOpHelpers::extensionOf("folder/..").empty());
+static_assert([] {
+	char buffer[64]{};
+	return FileOpHelpers::withSuffix("folder.d/message.txt", 4'294'967'295u, buffer) == "folder.d/message (4294967295).txt";
+}());
+static_assert([] {
+	char buffer[64]{};
+	return FileOpHelpers::unSuffix(std::string_view{ "/test/message   (3475)    " }, buffer) == "/test/message";
+}());
+
+TEST(FileOpHelperTests, UnsuffixingIntoBuffers)
+{
+	char buffer[64];
+
+	// the same answers as the allocating versions
+	for (const char* path : { "/test/message (2).txt", "/test/message     (123123123)   .txt", "/test/message (37)  d .txt",
+		"/test/message   (3475)    ", "    (2345)            ", "test (1)/no extension" }) {
+		ASSERT_EQ(FileOpHelpers::unSuffix(std::string_view{ path }, buffer), FileOpHelpers::unSuffix(std::string{ path }));
+		// and it can go straight to a system call
+		ASSERT_EQ(buffer[FileOpHelpers::unSuffix(std::string{ path }).size()], '\0');
+	}
+
+	ASSERT_EQ(FileOpHelpers::withSuffix("test/message.txt", 1, buffer), "test/message.txt");
+	ASSERT_EQ(FileOpHelpers::withSuffix("test/message.txt", 12, buffer), "test/message (12).txt");
+	ASSERT_EQ(FileOpHelpers::withSuffix("test.d/message", 3, buffer), "test.d/message (3)");
+	ASSERT_EQ(FileOpHelpers::withSuffix("test/.bashrc", 2, buffer), "test/.bashrc (2)");
+
+	ASSERT_EQ(FileOpHelpers::renamePath("test/message.txt", "renamed", buffer), "test/renamed.txt");
+	ASSERT_EQ(FileOpHelpers::renamePath("message", "renamed", buffer), "renamed");
+	ASSERT_EQ(FileOpHelpers::renamePath("test/message.txt", "renamed", buffer), FileOpHelpers::renamePath("test/message.txt", "renamed").string());
+
+	// doesn't fit
+	char small[8];
+	ASSERT_TRUE(FileOpHelpers::withSuffix("test/message.txt", 2, small).empty());
+	ASSERT_TRUE(FileOpHelpers::renamePath("test/message.txt", "renamed", small).empty());
 }
 
 TEST(FileOpHelperTests, DirectoryCreation)
@@ -112,6 +223,50 @@ TEST(FileOpHelperTests, DirectoryCreation)
 	ASSERT_FALSE(std::filesystem::exists(fullPath));
 }
 
+TEST(FileOpHelperTests, FolderCache)
+{
+	const std::string folder{ "test/folder cache/" };
+
+	// clean folder from previous tests
+	cleanFolder(folder);
+
+	// first write actually makes it, after that it should come out of the cache. the cache goes by absolute path, so
+	// spelling the same folder differently still hits
+	FileOpHelpers::FolderCacheStats before{ FileOpHelpers::folderCacheStats() };
+	ASSERT_TRUE(FileOperations::writeStringToFile("asdf", folder + "cached/file.txt"));
+	ASSERT_TRUE(FileOperations::writeStringToFile("asdf", folder + "cached/other file.txt"));
+	ASSERT_TRUE(FileOperations::writeStringToFile("asdf", std::filesystem::absolute(folder) / "./cached/third file.txt"));
+	FileOpHelpers::FolderCacheStats after{ FileOpHelpers::folderCacheStats() };
+	ASSERT_EQ(after.misses - before.misses, 1);
+	ASSERT_EQ(after.hits - before.hits, 2);
+
+	// createFolder() always asks the file system, so it sees folders the library itself removed or moved away
+	ASSERT_TRUE(FileOpHelpers::createFolder(folder + "gone/file.txt"));
+	ASSERT_TRUE(FileOperations::writeStringToFile("asdf", folder + "gone/file.txt"));
+	FileOperations::deleteFile(folder + "gone/file.txt");
+	FileOperations::deleteFile(folder + "gone");
+	ASSERT_TRUE(FileOpHelpers::createFolder(folder + "gone/file.txt"));
+	ASSERT_TRUE(std::filesystem::exists(folder + "gone"));
+	ASSERT_TRUE(FileOperations::renameFile(folder + "gone", "moved"));
+	ASSERT_TRUE(FileOpHelpers::createFolder(folder + "gone"));
+	ASSERT_TRUE(std::filesystem::exists(folder + "gone"));
+
+	// delete it behind the cache's back. writing should still work, since it notices and makes the folder again
+	std::filesystem::remove_all(folder);
+	ASSERT_TRUE(FileOperations::writeStringToFile("asdf", folder + "cached/file.txt"));
+	ASSERT_TRUE(std::filesystem::exists(folder + "cached/file.txt"));
+	std::filesystem::remove_all(folder);
+	ASSERT_TRUE(FileOperations::writeStringsToFile({ "asdf" }, folder + "cached/file.txt"));
+	ASSERT_TRUE(std::filesystem::exists(folder + "cached/file.txt"));
+
+	// forgetting the parent forgets the sub folder too, so the next write goes back to the file system
+	FileOpHelpers::forgetFolder(folder);
+	before = FileOpHelpers::folderCacheStats();
+	ASSERT_TRUE(FileOperations::writeStringToFile("asdf", folder + "cached/file.txt"));
+	after = FileOpHelpers::folderCacheStats();
+	ASSERT_EQ(after.misses - before.misses, 1);
+}
+
 TEST(FileOpHelperTests, UnusedFileNames)
 {
 	const std::string folder{ "test/unused file names/" };
@@ -135,6 +290,43 @@ TEST(FileOpHelperTests, UnusedFileNames)
 	}
 }
 
+TEST(FileOpHelperTests, UnusedFileNameIndex)
+{
+	const std::string folder{ "test/unused name index/" };
+	const std::string fileName{ "index" };
+	const std::string ext{ ".txt" };
+
+	// clean folder from previous tests
+	cleanFolder(folder);
+
+	// leave a gap at (3). the oddly spaced one shouldn't count as taking (3), since the exists() version wouldn't
+	// see it either
+	FileOperations::writeStringToFile("asdf", folder + "index.txt");
+	FileOperations::writeStringToFile("asdf", folder + "index (2).txt");
+	FileOperations::writeStringToFile("asdf", folder + "index (4).txt");
+	FileOperations::writeStringToFile("asdf", folder + "index   (3)  .txt");
+
+	FileOpHelpers::UnusedNameIndex index{ folder };
+
+	// it should agree with the regular version
+	ASSERT_EQ(
+		FileOpHelpers::getFirstUnusedFileName(folder + "index (2).txt", index),
+		FileOpHelpers::getFirstUnusedFileName(folder + "index (2).txt")
+	);
+	// and hand out the rest in order, without us having to create the files
+	ASSERT_EQ(index.getFirstUnusedFileName(folder + "index.txt").string(), folder + "index (5).txt");
+	ASSERT_EQ(index.getFirstUnusedFileName(folder + "index.txt").string(), folder + "index (6).txt");
+	// a name nobody has used yet
+	ASSERT_EQ(index.getFirstUnusedFileName(folder + "other.txt").string(), folder + "other.txt");
+
+	// copying through the index should pick up where the folder actually is after a rescan
+	index.rescan();
+	FileOperations::copyFile(folder + "index.txt", index);
+	ASSERT_TRUE(std::filesystem::exists(folder + "index (3).txt"));
+	FileOperations::copyFile(folder + "index.txt", index);
+	ASSERT_TRUE(std::filesystem::exists(folder + "index (5).txt"));
+}
+
 TEST(FileOperationTests, CopyingFile)
 {
 	const std::string folder{ "test/copying/" };
@@ -161,6 +353,24 @@ TEST(FileOperationTests, CopyingFile)
 	unusedName = FileOpHelpers::getFirstUnusedFileName(fullName);
 	FileOperations::copyFile(fullName);
 	ASSERT_TRUE(std::filesystem::exists(unusedName));
+
+	// it should tell us where the copy went, and the copy should match byte for byte
+	std::string big(3 * 1024 * 1024 + 17, 'x');
+	FileOperations::writeStringToFile(big, folder + "big.bin");
+
+	FileOperations::CopyResult result{ FileOperations::copyFile(folder + "big.bin") };
+	ASSERT_EQ(result.destination.string(), folder + "big (2).bin");
+	ASSERT_EQ(std::filesystem::file_size(result.destination), std::filesystem::file_size(folder + "big.bin"));
+#ifndef _WIN32
+	ASSERT_NE(result.strategy, FileOpHelpers::CopyStrategy::Filesystem);
+#endif
+
+	std::ifstream original{ folder + "big.bin", std::ios::binary };
+	std::ifstream copy{ result.destination, std::ios::binary };
+	ASSERT_TRUE(std::equal(std::istreambuf_iterator<char>(original), {}, std::istreambuf_iterator<char>(copy), {}));
+
+	// copying over something that already exists should fail instead of clobbering it
+	ASSERT_THROW(FileOpHelpers::copyFileContents(folder + "big.bin", result.destination), std::filesystem::filesystem_error);
 }
 
 TEST(FileOperationTests, RenamingFile)
@@ -217,6 +427,17 @@ TEST(FileOperationTests, OpenInExplorer)
 
 	// create the folder
 	FileOpHelpers::createFolder(folder);
+#ifndef _WIN32
+	// headless boxes (ci, containers) often have nothing to open it with
+#ifdef __APPLE__
+	const char* opener{ "open" };
+#else
+	const char* opener{ "xdg-open" };
+#endif
+	if (std::system(std::format("command -v {} > /dev/null 2>&1", opener).c_str()) != 0) {
+		GTEST_SKIP() << "no " << opener << " to open folders with";
+	}
+#endif
 	// open it
 	ASSERT_TRUE(FileOperations::openInExplorer(folder));
 	// test opening something that doesn't exist
@@ -231,6 +452,13 @@ TEST(FileOperationTests, SendToRecycleBin)
 	// clean folder from previous tests
 	cleanFolder(folder);
 
+#if !defined(_WIN32) && !defined(__APPLE__)
+	// keep the test out of the real trash
+	std::filesystem::path dataHome{ std::filesystem::absolute(folder + "data home") };
+	std::string oldDataHome{ getenv("XDG_DATA_HOME") ? getenv("XDG_DATA_HOME") : "" };
+	setenv("XDG_DATA_HOME", dataHome.c_str(), 1);
+#endif
+
 	// create file
 	FileOperations::writeStringToFile("this file should get recycled", fullName);
 	ASSERT_TRUE(std::filesystem::exists(fullName));
@@ -241,6 +469,17 @@ TEST(FileOperationTests, SendToRecycleBin)
 
 	// try sending it again
 	ASSERT_FALSE(FileOperations::sendToRecycleBin(fullName));
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+	ASSERT_TRUE(std::filesystem::exists(dataHome / "Trash/files/recycle.txt"));
+
+	if (oldDataHome.empty()) {
+		unsetenv("XDG_DATA_HOME");
+	}
+	else {
+		setenv("XDG_DATA_HOME", oldDataHome.c_str(), 1);
+	}
+#endif
 }
 
 TEST(FileOperationTests, GetAllFilesInFolder)
@@ -278,6 +517,1194 @@ TEST(FileOperationTests, GetAllFilesInFolder)
 	}
 }
 
+TEST(FileOperationTests, IteratingFilesInFolder)
+{
+	const std::string folder{ "test/iterating files/" };
+
+	// clean folder from previous tests
+	cleanFolder(folder);
+
+	// a handful of files, plus a sub folder that should get skipped
+	for (int i{ 0 }; i < 5; ++i) {
+		FileOperations::writeStringToFile("asdf1234", FileOpHelpers::getFirstUnusedFileName(folder + "iterate.txt"));
+	}
+	FileOperations::writeStringToFile("asdf1234", folder + "iterate.csv");
+	FileOpHelpers::createFolder(folder + "sub folder");
+
+	int count{ 0 };
+	for (const auto& entry : FileOperations::filesInFolder(folder)) {
+		ASSERT_FALSE(entry.is_directory());
+		++count;
+	}
+	ASSERT_EQ(count, 6);
+
+	// filtering
+	count = 0;
+	for (const auto& entry : FileOperations::filesInFolder(folder, ".csv")) {
+		ASSERT_EQ(entry.path().extension(), ".csv");
+		++count;
+	}
+	ASSERT_EQ(count, 1);
+
+	// stopping early
+	count = 0;
+	for (const auto& entry : FileOperations::filesInFolder(folder, ".txt")) {
+		(void)entry;
+		if (++count == 2) break;
+	}
+	ASSERT_EQ(count, 2);
+
+	// the vector version should see the same thing
+	ASSERT_EQ(FileOperations::getAllFilesInFolder(folder).size(), 6);
+}
+TEST(FileOperationTests, GetAllFilesInFolderRecursive)
+{
+	const std::string folder{ "test/recursive files/" };
+
+	// clean folder from previous tests
+	cleanFolder(folder);
+
+	// a small tree. 3 files per folder, 3 levels deep, a couple of sub folders per level
+	int numFiles{ 0 };
+	for (const std::string sub : { "", "a/", "b/", "a/c/", "a/d/", "b/e/" }) {
+		for (int i{ 0 }; i < 3; ++i) {
+			FileOperations::writeStringToFile("asdf1234", FileOpHelpers::getFirstUnusedFileName(folder + sub + "walk.txt"));
+			++numFiles;
+		}
+		FileOperations::writeStringToFile("asdf1234", folder + sub + "walk.csv");
+	}
+
+	FileOperations::RecursiveOptions options;
+	options.fileType = ".txt";
+	options.threadCount = 4;
+
+	std::vector<std::filesystem::path> files{ FileOperations::getAllFilesInFolderRecursive(folder, options) };
+	ASSERT_EQ(files.size(), numFiles);
+	for (const auto& file : files) {
+		ASSERT_EQ(file.extension(), ".txt");
+		ASSERT_TRUE(std::filesystem::is_regular_file(file));
+	}
+
+	// no filter picks up the csv files too
+	options.fileType = "";
+	ASSERT_EQ(FileOperations::getAllFilesInFolderRecursive(folder, options).size(), numFiles + 6);
+
+	// depth 0 should match the non recursive version
+	options.maxDepth = 0;
+	ASSERT_EQ(FileOperations::getAllFilesInFolderRecursive(folder, options).size(), FileOperations::getAllFilesInFolder(folder).size());
+	options.maxDepth = 1;
+	ASSERT_EQ(FileOperations::getAllFilesInFolderRecursive(folder, options).size(), 12);
+
+	// callback version
+	std::atomic<int> count{ 0 };
+	options.maxDepth = -1;
+	FileOperations::forEachFileRecursive(folder, [&count](const std::filesystem::path&) { ++count; }, options);
+	ASSERT_EQ(count, numFiles + 6);
+
+	// a folder that isn't there should throw, just like getAllFilesInFolder()
+	ASSERT_THROW(FileOperations::getAllFilesInFolderRecursive(folder + "doesnt exist"), std::filesystem::filesystem_error);
+
+#ifndef _WIN32
+	// a link back up the tree shouldn't get walked through even once
+	const std::string loop{ "test/recursive loop/" };
+	cleanFolder(loop);
+	FileOperations::writeStringToFile("asdf1234", loop + "a/b/x.txt");
+	std::filesystem::create_directory_symlink("..", loop + "a/b/up");
+
+	FileOperations::RecursiveOptions following;
+	following.followSymlinks = true;
+	files = FileOperations::getAllFilesInFolderRecursive(loop, following);
+	ASSERT_EQ(files.size(), 1);
+	ASSERT_EQ(files[0], std::filesystem::path{ loop + "a/b/x.txt" });
+#endif
+}
+TEST(FileOperationTests, ReadingFile)
+{
+	const std::string folder{ "test/reading/" };
+	const std::string fullName{ folder + "read.txt" };
+
+	// clean folder from previous tests
+	cleanFolder(folder);
+
+	// reading should give back exactly what we wrote, including empty lines
+	const std::vector<std::string> strings{ "first line", "", "third line with some more text", "last" };
+	FileOperations::writeStringsToFile(strings, fullName);
+
+	FileOperations::FileContents contents{ FileOperations::readFile(fullName) };
+	ASSERT_TRUE(contents.isMapped());
+
+	std::vector<std::string_view> lines{ FileOperations::readLines(contents) };
+	ASSERT_EQ(lines.size(), strings.size());
+	for (size_t i{ 0 }; i < lines.size(); ++i) {
+		ASSERT_EQ(lines[i], strings[i]);
+	}
+
+	// moving it shouldn't invalidate the views
+	FileOperations::FileContents moved{ std::move(contents) };
+	ASSERT_EQ(FileOperations::readLines(moved)[2], strings[2]);
+
+#ifndef _WIN32
+	// strings that really end in '\r' only come back whole if we ask for it
+	const std::vector<std::string> returns{ "ends in a return\r", "\r", "normal", "last\r" };
+	FileOperations::writeStringsToFile(returns, folder + "returns.txt");
+	FileOperations::FileContents returnsContents{ FileOperations::readFile(folder + "returns.txt") };
+	std::vector<std::string_view> kept{ FileOperations::readLines(returnsContents, FileOperations::CarriageReturns::Keep) };
+	ASSERT_EQ(std::vector<std::string>(kept.begin(), kept.end()), returns);
+	ASSERT_EQ(FileOperations::readLines(returnsContents)[0], "ends in a return");
+#endif
+
+	// an empty file can't be mapped, so it takes the buffered path
+	FileOperations::writeStringToFile("", folder + "empty.txt", std::ios_base::out);
+	std::filesystem::resize_file(folder + "empty.txt", 0);
+	FileOperations::FileContents empty{ FileOperations::readFile(folder + "empty.txt") };
+	ASSERT_FALSE(empty.isMapped());
+	ASSERT_TRUE(FileOperations::readLines(empty).empty());
+
+	ASSERT_THROW(FileOperations::readFile(folder + "doesnt exist.txt"), std::filesystem::filesystem_error);
+}
+TEST(FileOpHelperTests, SplittingLines)
+{
+	// lines of every length around the 16/32 byte block sizes, plus some "\r\n" endings
+	std::string text;
+	std::vector<std::string> expected;
+	for (int i{ 0 }; i < 100; ++i) {
+		expected.push_back(std::string(i % 40, 'a' + i % 26));
+		text += expected.back() + (i % 3 == 0 ? "\r\n" : "\n");
+	}
+	text += "partial";
+
+	for (FileOpHelpers::SimdLevel level : { FileOpHelpers::SimdLevel::Scalar, FileOpHelpers::SimdLevel::SSE2, FileOpHelpers::SimdLevel::AVX2 }) {
+		std::vector<std::string_view> lines;
+		size_t used{ FileOpHelpers::splitLines(text.data(), text.size(), lines, level) };
+
+		ASSERT_EQ(used, text.size() - 7);
+		ASSERT_EQ(lines.size(), expected.size());
+		for (size_t i{ 0 }; i < lines.size(); ++i) {
+			ASSERT_EQ(lines[i], expected[i]);
+		}
+	}
+}
+
+TEST(FileOperationTests, StreamingLines)
+{
+	const std::string folder{ "test/streaming lines/" };
+	const std::string fullName{ folder + "stream.txt" };
+
+	// clean folder from previous tests
+	cleanFolder(folder);
+
+	std::vector<std::string> strings;
+	for (int i{ 0 }; i < 5000; ++i) {
+		strings.push_back(std::format("line {} {}", i, std::string(i % 97, 'x')));
+	}
+	// one line that's way longer than the buffer
+	strings.push_back(std::string(1000, 'y'));
+	strings.push_back("");
+	FileOperations::writeStringsToFile(strings, fullName);
+
+	// a tiny buffer, so lots of lines straddle two reads
+	FileOperations::LineReader reader{ fullName, 64 };
+	std::vector<std::string_view> lines;
+	size_t i{ 0 };
+	while (reader.nextBatch(lines)) {
+		for (std::string_view line : lines) {
+			ASSERT_LT(i, strings.size());
+			ASSERT_EQ(line, strings[i]);
+			++i;
+		}
+	}
+	ASSERT_EQ(i, strings.size());
+
+	// a file without a trailing newline still gives us the last line
+	FileOperations::writeStringToFile("a\r\nb", folder + "no newline.txt");
+	std::filesystem::resize_file(folder + "no newline.txt", 4);
+	FileOperations::LineReader shortReader{ folder + "no newline.txt" };
+	std::vector<std::string> collected;
+	while (shortReader.nextBatch(lines)) {
+		collected.insert(collected.end(), lines.begin(), lines.end());
+	}
+	ASSERT_EQ(collected, (std::vector<std::string>{ "a", "b" }));
+
+	// keeping the '\r's, including ones that land right at the end of a buffer
+	std::vector<std::string> returns;
+	for (int i{ 0 }; i < 500; ++i) {
+		returns.push_back(std::string(i % 13, 'r') + (i % 2 == 0 ? "\r" : "") + (i % 5 == 0 ? "\r" : ""));
+	}
+	FileOperations::writeStringsToFile(returns, folder + "returns.txt");
+	FileOperations::LineReader keepingReader{ folder + "returns.txt", 16, FileOperations::CarriageReturns::Keep };
+	collected.clear();
+	while (keepingReader.nextBatch(lines)) {
+		collected.insert(collected.end(), lines.begin(), lines.end());
+	}
+	ASSERT_EQ(collected, returns);
+
+	// and stripping only ever takes off the one right before the '\n', wherever the buffer got split
+	FileOperations::LineReader strippingReader{ folder + "returns.txt", 16 };
+	collected.clear();
+	while (strippingReader.nextBatch(lines)) {
+		collected.insert(collected.end(), lines.begin(), lines.end());
+	}
+	ASSERT_EQ(collected.size(), returns.size());
+	for (size_t j{ 0 }; j < returns.size(); ++j) {
+		std::string expected{ returns[j] };
+		if (!expected.empty() && expected.back() == '\r') {
+			expected.pop_back();
+		}
+		ASSERT_EQ(collected[j], expected);
+	}
+
+	// a split between the '\r's of "\r\r\n" keeps the first one. every buffer size, so every split gets hit
+	FileOperations::writeStringToFile("abc\r\r\nxyz", folder + "split returns.txt");
+	for (size_t bufferSize{ 1 }; bufferSize <= 12; ++bufferSize) {
+		FileOperations::LineReader splitReader{ folder + "split returns.txt", bufferSize };
+		collected.clear();
+		while (splitReader.nextBatch(lines)) {
+			collected.insert(collected.end(), lines.begin(), lines.end());
+		}
+		ASSERT_EQ(collected, (std::vector<std::string>{ "abc\r", "xyz" })) << bufferSize;
+	}
+}
+
+TEST(FileOperationTests, WritingStrings)
+{
+	const std::string folder{ "test/writing strings/" };
+	const std::string fullName{ folder + "write.txt" };
+
+	// clean folder from previous tests
+	cleanFolder(folder);
+
+	// enough lines to need more than one batch of writes, with some empty ones mixed in
+	std::vector<std::string> strings;
+	std::string expected;
+	for (int i{ 0 }; i < 3000; ++i) {
+		strings.push_back(i % 7 == 0 ? "" : std::format("line {}", i));
+		expected += strings.back() + '\n';
+	}
+
+	ASSERT_TRUE(FileOperations::writeStringsToFile(strings, fullName));
+	ASSERT_EQ(FileOperations::readFile(fullName).view(), expected);
+
+	// writing again truncates by default
+	ASSERT_TRUE(FileOperations::writeStringsToFile({ "short" }, fullName));
+	ASSERT_EQ(FileOperations::readFile(fullName).view(), "short\n");
+
+	// and appends if you ask it to
+	ASSERT_TRUE(FileOperations::writeStringsToFile({ "more", "lines" }, fullName, std::ios_base::app));
+	ASSERT_EQ(FileOperations::readFile(fullName).view(), "short\nmore\nlines\n");
+}
+TEST(FileOperationTests, WritingRanges)
+{
+	const std::string folder{ "test/writing ranges/" };
+	const std::string fullName{ folder + "write.txt" };
+
+	// clean folder from previous tests
+	cleanFolder(folder);
+
+	struct Row
+	{
+		int id;
+		double value;
+	};
+
+	// enough rows to go past the writer's buffer a few times
+	std::vector<Row> rows;
+	std::vector<std::string> strings;
+	for (int i{ 0 }; i < 100'000; ++i) {
+		rows.push_back({ i, i / 8.0 });
+		strings.push_back(i % 7 == 0 ? "" : std::format("{},{}", rows.back().id, rows.back().value));
+	}
+	auto format{ [](auto out, const Row& row) {
+		return row.id % 7 == 0 ? out : std::format_to(out, "{},{}", row.id, row.value);
+	} };
+
+	// the same bytes as writing out the formatted strings
+	ASSERT_TRUE(FileOperations::writeStringsToFile(strings, fullName));
+	std::string expected{ FileOperations::readFile(fullName).view() };
+	ASSERT_TRUE(FileOperations::writeStringsToFile(rows, format, fullName));
+	ASSERT_EQ(FileOperations::readFile(fullName).view(), expected);
+
+	// anything you can loop over works, like a view that makes the lines up as it goes
+	ASSERT_TRUE(FileOperations::writeStringsToFile(std::views::iota(0, 3), [](auto out, int i) { *out = char('a' + i); }, fullName));
+	ASSERT_EQ(FileOperations::readFile(fullName).view(), "a\nb\nc\n");
+	ASSERT_TRUE(FileOperations::writeStringsToFile(std::vector<std::string_view>{ "d" }, [](auto out, std::string_view s) {
+		std::ranges::copy(s, out);
+	}, fullName, std::ios_base::app));
+	ASSERT_EQ(FileOperations::readFile(fullName).view(), "a\nb\nc\nd\n");
+
+	// a format that throws is an error, not an exception
+	std::error_code ec;
+	ASSERT_FALSE(FileOperations::writeStringsToFile(rows, [](auto out, const Row& row) {
+		if (row.id == 50'000) {
+			throw std::runtime_error("bad row");
+		}
+		return std::format_to(out, "{}", row.id);
+	}, fullName, ec));
+	ASSERT_EQ(ec, std::errc::invalid_argument);
+
+	ASSERT_FALSE(FileOperations::writeStringsToFile(rows, format, folder + "write.txt/inside.txt", ec));
+	ASSERT_EQ(ec, std::errc::not_a_directory);
+}
+TEST(FileOperationTests, LargeWriting)
+{
+	const std::string folder{ "test/large writing/" };
+	const std::string fullName{ folder + "large.txt" };
+
+	// clean folder from previous tests
+	cleanFolder(folder);
+
+	// small chunks, so it goes through plenty of them. and not a multiple of 4KB, so the tail takes the other path
+	FileOperations::LargeWriteOptions options;
+	options.chunkSize = 64 << 10;
+	options.expectedSize = 8 << 20;
+
+	std::string blob(3'000'001, 'x');
+	for (size_t i{ 0 }; i < blob.size(); i += 4093) {
+		blob[i] = static_cast<char>('a' + i % 26);
+	}
+
+	for (bool direct : { false, true }) {
+		options.direct = direct;
+
+		ASSERT_TRUE(FileOperations::writeStringToFile(blob, fullName, options));
+		// same bytes as the regular version, and the extra that was reserved isn't part of the file
+		ASSERT_EQ(FileOperations::readFile(fullName).view(), blob + '\n');
+		ASSERT_EQ(std::filesystem::file_size(fullName), blob.size() + 1);
+
+		// and appending on top of that, which doesn't start on a block boundary
+		std::vector<int> numbers(200'000);
+		std::string expected{ blob + '\n' };
+		for (int i{ 0 }; i < static_cast<int>(numbers.size()); i++) {
+			numbers[i] = i;
+			expected += std::format("{}\n", i);
+		}
+		ASSERT_TRUE(FileOperations::writeStringsToFile(numbers, [](auto out, int i) { return std::format_to(out, "{}", i); },
+			fullName, options, std::ios_base::app));
+		ASSERT_EQ(FileOperations::readFile(fullName).view(), expected);
+	}
+
+	std::error_code ec;
+	ASSERT_FALSE(FileOperations::writeStringToFile(blob, fullName + "/inside.txt", options, std::ios_base::out, ec));
+	ASSERT_EQ(ec, std::errc::not_a_directory);
+}
+TEST(FileOperationTests, Appending)
+{
+	const std::string folder{ "test/appending/" };
+	const std::string fullName{ folder + "append.txt" };
+
+	// clean folder from previous tests
+	cleanFolder(folder);
+
+	const int numThreads{ 4 };
+	const int linesPerThread{ 2000 };
+	{
+		// small threshold so it's flushing constantly while the threads are still going
+		FileOperations::AppenderOptions options;
+		options.flushBytes = 1024;
+		FileOperations::Appender appender{ fullName, options };
+
+		std::vector<std::thread> threads;
+		for (int t{ 0 }; t < numThreads; ++t) {
+			threads.emplace_back([&appender, t, linesPerThread] {
+				for (int i{ 0 }; i < linesPerThread; ++i) {
+					appender.append(std::format("thread {} line {} {}", t, i, std::string(i % 50, 'z')));
+				}
+			});
+		}
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+
+		// everything should be on disk right after flush() returns
+		ASSERT_TRUE(appender.flush());
+		FileOperations::FileContents contents{ FileOperations::readFile(fullName) };
+		ASSERT_EQ(FileOperations::readLines(contents).size(), numThreads * linesPerThread);
+
+		// and the destructor should write out anything left over
+		appender.append("last line");
+	}
+
+	FileOperations::FileContents contents{ FileOperations::readFile(fullName) };
+	std::vector<std::string_view> lines{ FileOperations::readLines(contents) };
+	ASSERT_EQ(lines.size(), numThreads * linesPerThread + 1);
+	ASSERT_EQ(lines.back(), "last line");
+
+	// every line should be whole, and each thread's lines should still be in order
+	std::vector<int> nextLine(numThreads, 0);
+	for (size_t i{ 0 }; i + 1 < lines.size(); ++i) {
+		int t{ lines[i][7] - '0' };
+		ASSERT_EQ(lines[i], std::format("thread {} line {} {}", t, nextLine[t], std::string(nextLine[t] % 50, 'z')));
+		++nextLine[t];
+	}
+}
+TEST(FileOperationTests, AtomicWriting)
+{
+	const std::string folder{ "test/atomic writing/" };
+	const std::string fullName{ folder + "atomic.txt" };
+
+	// clean folder from previous tests
+	cleanFolder(folder);
+
+	// every durability level should end up with the same file
+	for (FileOperations::Durability durability : { FileOperations::Durability::None, FileOperations::Durability::DataSync, FileOperations::Durability::FullSync }) {
+		FileOperations::AtomicWriteOptions options;
+		options.durability = durability;
+
+		ASSERT_TRUE(FileOperations::writeStringToFileAtomic("this replaces the whole file", fullName, options));
+		ASSERT_EQ(FileOperations::readFile(fullName).view(), "this replaces the whole file\n");
+
+		ASSERT_TRUE(FileOperations::writeStringsToFileAtomic({ "one", "two" }, fullName, options));
+		ASSERT_EQ(FileOperations::readFile(fullName).view(), "one\ntwo\n");
+	}
+
+	// a name close to the limit still works, even though the temp file's name has extra bits on both ends. (the 'é'
+	// sits right where the temp name gets cut)
+	const std::string longName{ folder + std::string(217, 'x') + "\xc3\xa9" + std::string(29, 'x') + ".txt" };
+	ASSERT_TRUE(FileOperations::writeStringToFileAtomic("long", longName));
+	ASSERT_EQ(FileOperations::readFile(longName).view(), "long\n");
+
+	// a bunch of threads sharing sync phases
+	FileOperations::AtomicWriteOptions options;
+	options.groupCommit = true;
+
+	std::vector<std::thread> threads;
+	std::atomic<int> succeeded{ 0 };
+	for (int t{ 0 }; t < 8; ++t) {
+		threads.emplace_back([&, t] {
+			for (int i{ 0 }; i < 10; ++i) {
+				if (FileOperations::writeStringToFileAtomic(std::format("{} {}", t, i), std::format("{}group {}.txt", folder, t), options)) {
+					++succeeded;
+				}
+			}
+		});
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	ASSERT_EQ(succeeded, 80);
+	for (int t{ 0 }; t < 8; ++t) {
+		ASSERT_EQ(FileOperations::readFile(std::format("{}group {}.txt", folder, t)).view(), std::format("{} 9\n", t));
+	}
+
+	// no temp files should be left behind
+	ASSERT_EQ(FileOperations::getAllFilesInFolder(folder).size(), 10);
+}
+TEST(FileOperationTests, BatchWritingAndCopying)
+{
+	const std::string folder{ "test/batch/" };
+
+	// clean folder from previous tests
+	cleanFolder(folder);
+
+	// run it both ways. (io_uring might not be there at all, in which case both of these use the pool)
+	for (bool useIoUring : { true, false }) {
+		FileOperations::BatchOptions options;
+		options.useIoUring = useIoUring;
+		options.queueDepth = 32;
+		options.threadCount = 4;
+		FileOperations::BatchEngine batch{ options };
+
+		std::string sub{ folder + (useIoUring ? "ring/" : "pool/") };
+		for (int i{ 0 }; i < 200; ++i) {
+			// spread over a few folders, each of which the ring opens once
+			ASSERT_EQ(batch.submitWrite(std::format("{}{}/file {}.txt", sub, i % 3, i), std::format("contents {}", i)), i);
+		}
+		// one that can't work, since its "folder" is actually a file
+		FileOperations::writeStringToFile("asdf", sub + "blocker.txt");
+		batch.submitWrite(sub + "blocker.txt/nope.txt", "asdf");
+
+		std::vector<FileOperations::BatchCompletion> completions{ batch.run() };
+		ASSERT_EQ(completions.size(), 201);
+		for (const auto& completion : completions) {
+			ASSERT_EQ(completion.ok, completion.id != 200);
+		}
+		for (int i{ 0 }; i < 200; ++i) {
+			ASSERT_EQ(FileOperations::readFile(std::format("{}{}/file {}.txt", sub, i % 3, i)).view(), std::format("contents {}\n", i));
+		}
+
+		// several copies of the same file in one batch should all get their own name
+		for (int i{ 0 }; i < 5; ++i) {
+			batch.submitCopy(sub + "0/file 0.txt");
+		}
+		completions = batch.run();
+		ASSERT_EQ(completions.size(), 5);
+		for (const auto& completion : completions) {
+			ASSERT_TRUE(completion.ok);
+			ASSERT_EQ(FileOperations::readFile(completion.path).view(), "contents 0\n");
+		}
+		ASSERT_TRUE(std::filesystem::exists(sub + "0/file 0 (6).txt"));
+
+		// the name is only picked once the copy runs, so a file that shows up in between doesn't make it fail
+		batch.submitCopy(sub + "1/file 1.txt");
+		FileOperations::writeStringToFile("in the way", sub + "1/file 1 (2).txt");
+		completions = batch.run();
+		ASSERT_EQ(completions.size(), 1);
+		ASSERT_TRUE(completions[0].ok);
+		ASSERT_EQ(completions[0].path, sub + "1/file 1 (3).txt");
+		ASSERT_EQ(FileOperations::readFile(sub + "1/file 1 (2).txt").view(), "in the way\n");
+	}
+}
+TEST(FileOperationTests, FolderHandle)
+{
+	const std::string folder{ "test/folder handle/" };
+
+	// clean folder from previous tests
+	cleanFolder(folder);
+	FileOpHelpers::createFolder(folder);
+
+	FileOperations::Folder handle{ folder };
+
+	// writing
+	ASSERT_TRUE(handle.writeStringToFile("first", "handle.txt"));
+	ASSERT_TRUE(handle.writeStringToFile("second", "handle.txt", std::ios_base::app));
+	ASSERT_EQ(FileOperations::readFile(folder + "handle.txt").view(), "first\nsecond\n");
+
+	// unused names, same as the path version
+	ASSERT_EQ(handle.getFirstUnusedFileName("handle.txt"), "handle (2).txt");
+	ASSERT_EQ(handle.getFirstUnusedFileName("other.txt"), "other.txt");
+	ASSERT_EQ(handle.getFirstUnusedFileName("handle (7).txt"), "handle (2).txt");
+	ASSERT_THROW(handle.getFirstUnusedFileName(std::string(300, 'x') + ".txt"), std::filesystem::filesystem_error);
+
+	// copying
+	FileOperations::CopyResult result{ handle.copyFile("handle.txt") };
+	ASSERT_EQ(result.destination.filename(), "handle (2).txt");
+	ASSERT_EQ(FileOperations::readFile(result.destination).view(), "first\nsecond\n");
+
+	// renaming, which should refuse to replace anything
+	ASSERT_TRUE(handle.renameFile("handle (2).txt", "renamed"));
+	ASSERT_TRUE(std::filesystem::exists(folder + "renamed.txt"));
+	ASSERT_FALSE(handle.renameFile("handle.txt", "renamed"));
+	ASSERT_TRUE(std::filesystem::exists(folder + "handle.txt"));
+	ASSERT_FALSE(handle.renameFile("handle.txt", "?|<>*/\\"));
+
+	// deleting
+	ASSERT_TRUE(handle.deleteFile("renamed.txt"));
+	ASSERT_FALSE(handle.deleteFile("renamed.txt"));
+
+	// a folder that isn't there
+	ASSERT_THROW(FileOperations::Folder{ folder + "doesnt exist" }, std::filesystem::filesystem_error);
+}
+
+TEST(FileOperationTests, ConcurrentCopying)
+{
+	const std::string folder{ "test/concurrent copying/" };
+	cleanFolder(folder);
+
+	FileOperations::writeStringToFile("copy me", folder + "race.txt");
+
+	// lots of threads copying the same file at once should never end up with the same name
+	constexpr int threadCount{ 8 };
+	constexpr int copiesPerThread{ 25 };
+	std::vector<std::vector<std::filesystem::path>> destinations(threadCount);
+	std::vector<std::thread> threads;
+	for (int t{ 0 }; t < threadCount; t++) {
+		threads.emplace_back([&, t] {
+			for (int i{ 0 }; i < copiesPerThread; i++) {
+				destinations[t].push_back(FileOperations::copyFile(folder + "race.txt").destination);
+			}
+		});
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	std::set<std::filesystem::path> unique;
+	for (const auto& paths : destinations) {
+		for (const auto& path : paths) {
+			ASSERT_TRUE(unique.insert(path).second);
+			ASSERT_EQ(std::filesystem::file_size(path), std::filesystem::file_size(folder + "race.txt"));
+		}
+	}
+	ASSERT_EQ(unique.size(), threadCount * copiesPerThread);
+
+	// and once they're done, a lone copy goes back to using the first free name
+	std::filesystem::remove(folder + "race (2).txt");
+	ASSERT_EQ(FileOpHelpers::reserveUnusedFileName(folder + "race.txt").string(), folder + "race (2).txt");
+	ASSERT_TRUE(std::filesystem::exists(folder + "race (2).txt"));
+
+	// copying something that isn't there fails, and doesn't leave an empty file behind
+	ASSERT_THROW(FileOperations::copyFile(folder + "missing.txt"), std::filesystem::filesystem_error);
+	ASSERT_FALSE(std::filesystem::exists(folder + "missing.txt"));
+}
+
+TEST(FileOperationTests, ErrorCodes)
+{
+	const std::string folder{ "test/error codes/" };
+	cleanFolder(folder);
+
+	std::error_code ec;
+	const std::string missing{ folder + "missing.txt" };
+
+	// a file that isn't there. none of these throw, they just say why
+	FileOperations::CopyResult copy{ FileOperations::copyFile(missing, ec) };
+	ASSERT_EQ(ec, std::errc::no_such_file_or_directory);
+	ASSERT_TRUE(copy.destination.empty());
+	ASSERT_THROW(FileOperations::copyFile(missing), std::filesystem::filesystem_error);
+
+	FileOperations::FileContents contents{ FileOperations::readFile(missing, ec) };
+	ASSERT_EQ(ec, std::errc::no_such_file_or_directory);
+	ASSERT_EQ(contents.size(), 0);
+
+	ASSERT_TRUE(FileOperations::getAllFilesInFolder(missing, ec).empty());
+	ASSERT_EQ(ec, std::errc::no_such_file_or_directory);
+	ASSERT_TRUE(FileOperations::getAllFilesInFolderRecursive(missing, {}, ec).empty());
+	ASSERT_TRUE(ec);
+
+	int walked{ 0 };
+	for (const auto& entry : FileOperations::filesInFolder(missing, "", ec)) {
+		(void)entry;
+		++walked;
+	}
+	ASSERT_EQ(walked, 0);
+	ASSERT_EQ(ec, std::errc::no_such_file_or_directory);
+	FileOperations::forEachFileRecursive(missing, [](const std::filesystem::path&) {}, {}, ec);
+	ASSERT_TRUE(ec);
+
+	ASSERT_FALSE(FileOperations::deleteFile(missing, ec));
+	ASSERT_FALSE(ec);
+
+	// renaming
+	FileOperations::writeStringToFile("a", folder + "a.txt", ec);
+	ASSERT_FALSE(ec);
+	FileOperations::writeStringToFile("b", folder + "b.txt", ec);
+	ASSERT_FALSE(FileOperations::renameFile(folder + "a.txt", "b", ec));
+	ASSERT_EQ(ec, std::errc::file_exists);
+	ASSERT_FALSE(FileOperations::renameFile(folder + "a.txt", "b?", ec));
+	ASSERT_EQ(ec, std::errc::invalid_argument);
+	ASSERT_FALSE(FileOperations::renameFile(missing, "c", ec));
+	ASSERT_EQ(ec, std::errc::no_such_file_or_directory);
+	ASSERT_THROW(FileOperations::renameFile(missing, "c"), std::filesystem::filesystem_error);
+	ASSERT_TRUE(FileOperations::renameFile(folder + "a.txt", "c", ec));
+	ASSERT_FALSE(ec);
+
+	// writing somewhere a folder can't be made
+	ASSERT_FALSE(FileOperations::writeStringToFile("x", folder + "b.txt/inside.txt", ec));
+	ASSERT_TRUE(ec);
+	ASSERT_FALSE(FileOperations::writeStringsToFileAtomic({ "x" }, folder + "b.txt/inside.txt", {}, ec));
+	ASSERT_TRUE(ec);
+
+	// a throwing callback comes back as an error instead of taking the program down
+	FileOperations::forEachFileRecursive(folder, [](const std::filesystem::path&) { throw std::bad_alloc{}; }, {}, ec);
+	ASSERT_EQ(ec, std::errc::not_enough_memory);
+	FileOperations::forEachFileRecursive(folder, [](const std::filesystem::path&) { throw 5; }, {}, ec);
+	ASSERT_EQ(ec, std::errc::invalid_argument);
+
+	// the folder's fine, so filesInFolder() gets through all of it
+	walked = 0;
+	for (const auto& entry : FileOperations::filesInFolder(folder, ".txt", ec)) {
+		(void)entry;
+		++walked;
+	}
+	ASSERT_FALSE(ec);
+	ASSERT_EQ(walked, 2);
+
+#ifndef _WIN32
+	// a dangling symlink is just not a folder, same as in the throwing versions. it doesn't fail the whole listing
+	std::filesystem::create_symlink("nowhere.txt", folder + "dangling.txt");
+	ASSERT_EQ(FileOperations::getAllFilesInFolder(folder, ".txt", ec).size(), 3);
+	ASSERT_FALSE(ec);
+	ASSERT_EQ(FileOperations::getAllFilesInFolder(folder, ".txt").size(), 3);
+	walked = 0;
+	for (const auto& entry : FileOperations::filesInFolder(folder, ".txt", ec)) {
+		(void)entry;
+		++walked;
+	}
+	ASSERT_FALSE(ec);
+	ASSERT_EQ(walked, 3);
+	std::filesystem::remove(folder + "dangling.txt");
+#endif
+
+	// and the folder handle
+	FileOperations::Folder handle{ folder };
+	ASSERT_TRUE(handle.copyFile("missing.txt", ec).destination.empty());
+	ASSERT_EQ(ec, std::errc::no_such_file_or_directory);
+	ASSERT_FALSE(handle.renameFile("b.txt", "c", ec));
+	ASSERT_EQ(ec, std::errc::file_exists);
+	ASSERT_EQ(handle.getFirstUnusedFileName("b.txt", ec), "b (2).txt");
+	ASSERT_FALSE(ec);
+}
+
+TEST(FileOpHelperTests, ThreadPool)
+{
+	// lots of tiny tasks, some submitting more from inside of a worker, and the pool reused for every round. every one
+	// of them has to run exactly once, and wait() can't come back early or hang
+	FileOpHelpers::ThreadPool pool{ 4 };
+	for (int round{ 0 }; round < 20; round++) {
+		std::atomic<int> ran{ 0 };
+		for (int i{ 0 }; i < 1000; i++) {
+			pool.submit([&pool, &ran, i] {
+				ran++;
+				if (i % 10 == 0) {
+					pool.submit([&ran] { ran++; });
+				}
+			});
+		}
+		pool.wait();
+		ASSERT_EQ(ran, 1100);
+	}
+
+	// a task's exception comes back out of wait(), and the pool still works after that
+	pool.submit([] { throw std::runtime_error{ "task failed" }; });
+	ASSERT_THROW(pool.wait(), std::runtime_error);
+	std::atomic<int> after{ 0 };
+	FileOpHelpers::parallelFor(pool, 100, [&after](size_t) { after++; });
+	ASSERT_EQ(after, 100);
+}
+
+TEST(FileOpHelperTests, StatsHistogram)
+{
+	using FileOperations::Stats::Histogram;
+
+	// small values are exact, and every bucket's upper bound lands back in that bucket
+	for (uint64_t v{ 0 }; v < 16; v++) {
+		ASSERT_EQ(Histogram::upperBound(Histogram::bucketFor(v)), v);
+	}
+	for (uint64_t v : { 16ull, 17ull, 1000ull, 123'456'789ull, 1ull << 39 }) {
+		int bucket{ Histogram::bucketFor(v) };
+		ASSERT_GE(Histogram::upperBound(bucket), v);
+		ASSERT_LE(Histogram::upperBound(bucket) - v, v / 16);
+		ASSERT_EQ(Histogram::bucketFor(Histogram::upperBound(bucket)), bucket);
+	}
+	ASSERT_EQ(Histogram::bucketFor(~0ull), Histogram::bucketCount - 1);
+
+	Histogram h;
+	for (uint64_t v{ 1 }; v <= 100; v++) {
+		h.counts[Histogram::bucketFor(v * 1000)]++;
+	}
+	ASSERT_EQ(h.total(), 100);
+	ASSERT_NEAR(static_cast<double>(h.percentile(50)), 50'000, 50'000 / 16);
+	ASSERT_NEAR(static_cast<double>(h.percentile(99)), 99'000, 99'000 / 16);
+	ASSERT_EQ(Histogram{}.percentile(50), 0);
+}
+
+TEST(FileOperationTests, Stats)
+{
+	using FileOperations::Stats::Op;
+
+	const std::string folder{ "test/stats/" };
+	cleanFolder(folder);
+
+	std::atomic<int> hooked{ 0 };
+	FileOperations::Stats::setHook([&](const FileOperations::Stats::Event& event) {
+		if (event.op == Op::CopyFile) {
+			hooked++;
+		}
+	});
+	FileOperations::Stats::reset();
+
+	FileOperations::writeStringToFile("12345", folder + "a.txt");
+	FileOperations::writeStringsToFile({ "1", "22" }, folder + "b.txt");
+	// one of these on another thread, to check the shards get merged
+	std::thread{ [&] { FileOperations::copyFile(folder + "a.txt"); } }.join();
+	FileOperations::copyFile(folder + "a.txt");
+	std::error_code ec;
+	FileOperations::copyFile(folder + "missing.txt", ec);
+	FileOperations::renameFile(folder + "b.txt", "c");
+	FileOperations::deleteFile(folder + "c.txt");
+	FileOperations::getAllFilesInFolder(folder);
+
+	FileOperations::Stats::setHook(nullptr);
+	FileOperations::Stats::Snapshot stats{ FileOperations::Stats::snapshot() };
+
+	if constexpr (!FileOperations::Stats::enabled) {
+		// compiled out, so nothing gets recorded
+		ASSERT_EQ(hooked, 0);
+		for (const auto& op : stats.ops) {
+			ASSERT_EQ(op.calls, 0);
+		}
+		return;
+	}
+
+	ASSERT_EQ(hooked, 3);
+	ASSERT_EQ(stats[Op::WriteStringToFile].calls, 1);
+	ASSERT_EQ(stats[Op::WriteStringToFile].bytes, 6);
+	ASSERT_EQ(stats[Op::WriteStringsToFile].bytes, 5);
+	ASSERT_EQ(stats[Op::CopyFile].calls, 3);
+	ASSERT_EQ(stats[Op::CopyFile].errors, 1);
+	ASSERT_EQ(stats[Op::CopyFile].bytes, 12);
+	ASSERT_EQ(stats[Op::CopyFile].latency.total(), 3);
+	ASSERT_EQ(stats[Op::RenameFile].calls, 1);
+	ASSERT_EQ(stats[Op::DeleteFile].calls, 1);
+	ASSERT_EQ(stats[Op::GetAllFilesInFolder].calls, 1);
+	ASSERT_GT(stats[Op::CopyFile].totalNanoseconds, 0);
+
+	std::string json{ FileOperations::Stats::toJson(stats) };
+	ASSERT_NE(json.find("\"copyFile\":{\"calls\":3,\"errors\":1,\"bytes\":12,"), std::string::npos);
+
+	// reset starts everything over
+	FileOperations::Stats::reset();
+	ASSERT_EQ(FileOperations::Stats::snapshot()[Op::CopyFile].calls, 0);
+}
+
+TEST(FileOperationTests, WatchedFolder)
+{
+	const std::string folder{ "test/watched folder/" };
+	cleanFolder(folder);
+	FileOperations::writeStringToFile("", folder + "a.txt");
+	FileOperations::writeStringToFile("", folder + "b.csv");
+	std::filesystem::create_directory(folder + "sub");
+
+	FileOperations::WatchedFolder watched{ folder };
+
+	// should always agree with a fresh listing
+	auto check{ [&](const std::string& fileType) {
+		std::set<std::filesystem::path> expected;
+		for (const auto& entry : FileOperations::getAllFilesInFolder(folder, fileType)) {
+			expected.insert(entry.path());
+		}
+		std::vector<std::filesystem::path> files{ watched.getAllFiles(fileType) };
+		ASSERT_EQ(std::set<std::filesystem::path>(files.begin(), files.end()), expected);
+	} };
+	check("");
+	check(".txt");
+	ASSERT_TRUE(watched.contains("sub"));
+
+	// changes made after it started watching
+	FileOperations::writeStringToFile("", folder + "c.txt");
+	FileOperations::renameFile(folder + "a.txt", "renamed");
+	FileOperations::deleteFile(folder + "b.csv");
+	FileOperations::copyFile(folder + "c.txt");
+	std::filesystem::create_directory(folder + "another sub");
+	std::filesystem::rename(folder + "sub", folder + "moved sub");
+	check("");
+	check(".txt");
+	ASSERT_EQ(watched.getAllFileNames(".txt").size(), watched.getAllFiles(".txt").size());
+	ASSERT_FALSE(watched.contains("a.txt"));
+	ASSERT_TRUE(watched.contains("moved sub"));
+
+	// unused names come out of memory, and deleting a file frees its name up again
+	ASSERT_EQ(watched.getFirstUnusedFileName(folder + "c.txt"), FileOpHelpers::getFirstUnusedFileName(folder + "c.txt"));
+	FileOperations::deleteFile(folder + "c.txt");
+	ASSERT_EQ(watched.getFirstUnusedFileName(folder + "c (2).txt"), folder + "c.txt");
+
+	// the folder going away and coming back
+	std::filesystem::remove_all(folder);
+	std::error_code ec;
+	watched.getAllFiles("", ec);
+	ASSERT_EQ(ec, std::errc::no_such_file_or_directory);
+	FileOperations::writeStringToFile("", folder + "new.txt");
+	check("");
+	FileOperations::writeStringToFile("", folder + "newer.txt");
+	check("");
+}
+
+TEST(FileOpHelperTests, Hash64)
+{
+	// reference values from the xxhash repo
+	ASSERT_EQ(FileOpHelpers::hash64("", 0), 0xEF46DB3751D8E999ull);
+	ASSERT_EQ(FileOpHelpers::hash64("a", 1), 0xD24EC4F1A98C6E5Bull);
+	ASSERT_EQ(FileOpHelpers::hash64("abc", 3), 0x44BC2CF5AD770999ull);
+
+	// every tail length, and the 32 byte loop
+	std::string data(100, 'x');
+	std::set<uint64_t> hashes;
+	for (size_t size{ 0 }; size <= data.size(); size++) {
+		hashes.insert(FileOpHelpers::hash64(data.data(), size));
+	}
+	ASSERT_EQ(hashes.size(), data.size() + 1);
+	ASSERT_NE(FileOpHelpers::hash64(data.data(), data.size(), 1), FileOpHelpers::hash64(data.data(), data.size()));
+}
+
+TEST(FileOperationTests, FindingDuplicates)
+{
+	const std::string folder{ "test/duplicates/" };
+	cleanFolder(folder);
+
+	// a family of copies, a big file whose copy only differs in the middle (so only the full hash can tell), a big
+	// file with a real copy, and some loners
+	std::string big(100'000, 'b');
+	std::string almost{ big };
+	almost[50'000] = 'c';
+	FileOperations::writeStringToFile("same", folder + "copied.txt");
+	FileOperations::copyFile(folder + "copied.txt");
+	FileOperations::copyFile(folder + "copied.txt");
+	FileOperations::writeStringToFile("same", folder + "sub/elsewhere.txt");
+	FileOperations::writeStringToFile(big, folder + "big.bin");
+	FileOperations::writeStringToFile(almost, folder + "almost big.bin");
+	FileOperations::writeStringToFile(big, folder + "sub/big again.bin");
+	FileOperations::writeStringToFile("emaS", folder + "different.txt");
+	FileOperations::writeStringToFile("", folder + "empty 1.txt", std::ios_base::out);
+	std::filesystem::resize_file(folder + "empty 1.txt", 0);
+	std::filesystem::copy_file(folder + "empty 1.txt", folder + "empty 2.txt");
+
+	std::vector<FileOperations::DuplicateGroup> groups{ FileOperations::findDuplicates(folder) };
+	ASSERT_EQ(groups.size(), 2);
+
+	ASSERT_EQ(groups[0].original, folder + "big.bin");
+	ASSERT_EQ(groups[0].duplicates, std::vector<std::filesystem::path>{ folder + "sub/big again.bin" });
+	ASSERT_EQ(groups[0].size, big.size() + 1);
+
+	// the unsuffixed one is the original, even though "sub/elsewhere.txt" doesn't sort after it
+	ASSERT_EQ(groups[1].original, folder + "copied.txt");
+	std::set<std::filesystem::path> copies(groups[1].duplicates.begin(), groups[1].duplicates.end());
+	ASSERT_EQ(copies, (std::set<std::filesystem::path>{ folder + "copied (2).txt", folder + "copied (3).txt", folder + "sub/elsewhere.txt" }));
+	ASSERT_TRUE(groups[1].errors.empty());
+
+	// not recursive, and a hard link isn't a duplicate of what it links to
+	std::filesystem::create_hard_link(folder + "big.bin", folder + "linked.bin");
+	groups = FileOperations::findDuplicates(folder, { .recursive = false });
+	ASSERT_EQ(groups.size(), 1);
+	ASSERT_EQ(groups[0].duplicates.size(), 2);
+
+	// hard linking them, then deleting
+	groups = FileOperations::findDuplicates(folder, { .action = FileOperations::DuplicateAction::Hardlink });
+	for (const auto& group : groups) {
+		for (size_t i{ 0 }; i < group.duplicates.size(); i++) {
+			ASSERT_FALSE(group.errors[i]) << group.errors[i].message();
+			ASSERT_TRUE(std::filesystem::equivalent(group.original, group.duplicates[i]));
+		}
+	}
+	ASSERT_TRUE(FileOperations::findDuplicates(folder).empty());
+
+	// a real copy again, instead of a link
+	std::filesystem::remove(folder + "linked.bin");
+	std::filesystem::remove(folder + "copied (2).txt");
+	FileOperations::writeStringToFile("same", folder + "copied (2).txt");
+	groups = FileOperations::findDuplicates(folder, { .action = FileOperations::DuplicateAction::Delete });
+	ASSERT_EQ(groups.size(), 1);
+	ASSERT_FALSE(std::filesystem::exists(folder + "copied (2).txt"));
+	ASSERT_TRUE(std::filesystem::exists(folder + "copied.txt"));
+	ASSERT_EQ(FileOperations::readFile(folder + "almost big.bin").size(), almost.size() + 1);
+}
+
+TEST(FileOperationTests, ListingFolders)
+{
+	const std::string folder{ "test/listing/" };
+	cleanFolder(folder);
+
+	// sizes go up with the number, modified times go down
+	auto now{ std::filesystem::file_time_type::clock::now() };
+	for (int i{ 0 }; i < 20; i++) {
+		std::string name{ folder + std::format("file {}{}", i, i % 2 ? ".txt" : ".csv") };
+		FileOperations::writeStringToFile(std::string(static_cast<size_t>(i) * 10, 'x'), name);
+		std::filesystem::last_write_time(name, now - std::chrono::hours(i));
+	}
+	std::filesystem::create_directory(folder + "sub.txt");
+
+	// same files as getAllFilesInFolder(), on one thread and on the pool
+	for (size_t threshold : { size_t{ 4096 }, size_t{ 1 } }) {
+		FileOperations::ListingOptions options;
+		options.fileType = ".txt";
+		options.parallelThreshold = threshold;
+		FileOperations::FolderListing listing{ FileOperations::listFolder(folder, options) };
+
+		std::set<std::filesystem::path> expected;
+		for (const auto& entry : FileOperations::getAllFilesInFolder(folder, ".txt")) {
+			expected.insert(entry.path());
+		}
+		std::set<std::filesystem::path> listed;
+		for (size_t i{ 0 }; i < listing.size(); i++) {
+			listed.insert(listing.path(i));
+			ASSERT_EQ(listing.fileSize(i), std::filesystem::file_size(listing.path(i)));
+			ASSERT_FALSE(listing.isFolder(i));
+		}
+		ASSERT_EQ(listed, expected);
+	}
+
+	FileOperations::ListingOptions everything;
+	everything.includeFolders = true;
+	FileOperations::FolderListing listing{ FileOperations::listFolder(folder, everything) };
+	ASSERT_EQ(listing.size(), 21);
+
+	listing.sort(FileOperations::FolderListing::SortBy::Name);
+	ASSERT_EQ(listing.name(0), "file 0.csv");
+	ASSERT_EQ(listing.name(20), "sub.txt");
+	ASSERT_TRUE(listing.isFolder(20));
+
+	// newest first is the lowest numbers first
+	listing.filter([&](size_t i) { return !listing.isFolder(i); });
+	listing.sort(FileOperations::FolderListing::SortBy::ModifiedTime, true);
+	for (size_t i{ 0 }; i < listing.size(); i++) {
+		ASSERT_EQ(listing.name(i), std::format("file {}{}", i, i % 2 ? ".txt" : ".csv"));
+	}
+	ASSERT_TRUE(std::is_sorted(listing.modifiedTimes().rbegin(), listing.modifiedTimes().rend()));
+
+	listing.sort(FileOperations::FolderListing::SortBy::Size);
+	ASSERT_TRUE(std::is_sorted(listing.fileSizes().begin(), listing.fileSizes().end()));
+
+	// filtering keeps the order, and the names still line up with their sizes
+	ASSERT_EQ(listing.filter([&](size_t i) { return listing.fileSize(i) > 100; }), 10);
+	ASSERT_EQ(listing.size(), 10);
+	for (size_t i{ 0 }; i < listing.size(); i++) {
+		ASSERT_EQ(listing.name(i), std::format("file {}{}", i + 10, (i + 10) % 2 ? ".txt" : ".csv"));
+		ASSERT_EQ(listing.fileSize(i), (i + 10) * 10 + 1);
+	}
+
+	std::error_code ec;
+	FileOperations::listFolder(folder + "missing", {}, ec);
+	ASSERT_EQ(ec, std::errc::no_such_file_or_directory);
+}
+
+TEST(FileOperationTests, BulkOperations)
+{
+	const std::string folder{ "test/bulk operations/" };
+	cleanFolder(folder);
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+	// keep the test out of the real trash
+	std::string oldDataHome{ getenv("XDG_DATA_HOME") ? getenv("XDG_DATA_HOME") : "" };
+	setenv("XDG_DATA_HOME", std::filesystem::absolute(folder + "data home").c_str(), 1);
+#endif
+
+	using FileOperations::BulkAction;
+	auto makePlan{ [](const std::string& root) {
+		for (const char* name : { "a.txt", "b.txt", "c.txt", "d.txt", "e.txt", "sub/f.txt", "sub/g.txt" }) {
+			FileOperations::writeStringToFile(name, root + name);
+		}
+		for (int i{ 0 }; i < 500; i++) {
+			FileOperations::writeStringToFile(std::to_string(i), root + std::format("many/n{}.txt", i));
+		}
+
+		std::vector<FileOperations::BulkOperation> plan{
+			// a chain. c has to be out of the way before b can take its name
+			{ BulkAction::Rename, root + "c.txt", "z" },
+			{ BulkAction::Rename, root + "b.txt", "c" },
+			// a swap fails both ways, same as one at a time
+			{ BulkAction::Rename, root + "a.txt", "d" },
+			{ BulkAction::Rename, root + "d.txt", "a" },
+			// two renames to the same name. the second one finds it taken
+			{ BulkAction::Rename, root + "many/n0.txt", "same" },
+			{ BulkAction::Rename, root + "many/n1.txt", "same" },
+			{ BulkAction::Rename, root + "many/n2.txt", "bad/name" },
+			// copies get their numbers in plan order, including the one that frees up
+			{ BulkAction::Copy, root + "e.txt" },
+			{ BulkAction::Copy, root + "e.txt" },
+			{ BulkAction::Delete, root + "e (2).txt" },
+			{ BulkAction::Copy, root + "e.txt" },
+			// things inside a folder happen on the right side of the folder moving
+			{ BulkAction::Delete, root + "sub/g.txt" },
+			{ BulkAction::Rename, root + "sub", "moved" },
+			{ BulkAction::Delete, root + "moved/f.txt" },
+			{ BulkAction::Trash, root + "many/n3.txt" },
+			{ BulkAction::Delete, root + "many/n4.txt" },
+			{ BulkAction::Delete, root + "many/n4.txt" },
+			{ BulkAction::Copy, root + "missing.txt" },
+		};
+		// and a pile of independent ones
+		for (int i{ 5 }; i < 500; i++) {
+			plan.push_back({ i % 3 == 0 ? BulkAction::Delete : BulkAction::Rename, root + std::format("many/n{}.txt", i), std::format("m{}", i) });
+		}
+		return plan;
+	} };
+
+	// the same plan one operation at a time
+	std::string sequentialRoot{ folder + "sequential/" };
+	std::vector<FileOperations::BulkOperation> sequentialPlan{ makePlan(sequentialRoot) };
+	std::vector<FileOperations::BulkResult> expected(sequentialPlan.size());
+	for (size_t i{ 0 }; i < sequentialPlan.size(); i++) {
+		const FileOperations::BulkOperation& operation{ sequentialPlan[i] };
+		FileOperations::BulkResult& result{ expected[i] };
+		switch (operation.action) {
+		case BulkAction::Rename:
+			result.ok = FileOperations::renameFile(operation.path, operation.newName, result.error);
+			result.path = result.ok ? FileOpHelpers::renamePath(operation.path, operation.newName) : "";
+			break;
+		case BulkAction::Copy:
+			result.path = FileOperations::copyFile(operation.path, result.error).destination;
+			result.ok = !result.error;
+			break;
+		case BulkAction::Delete:
+			result.ok = FileOperations::deleteFile(operation.path, result.error);
+			result.path = result.error ? "" : operation.path;
+			break;
+		case BulkAction::Trash:
+			result.ok = FileOperations::sendToRecycleBin(operation.path, result.error);
+			result.path = result.ok ? operation.path : "";
+			break;
+		}
+	}
+
+	std::string bulkRoot{ folder + "bulk/" };
+	std::vector<FileOperations::BulkResult> results{ FileOperations::runBulkOperations(makePlan(bulkRoot), { .threadCount = 4 }) };
+
+	ASSERT_EQ(results.size(), expected.size());
+	for (size_t i{ 0 }; i < results.size(); i++) {
+		ASSERT_EQ(results[i].ok, expected[i].ok) << i;
+		ASSERT_EQ(results[i].error, expected[i].error) << i;
+		ASSERT_EQ(results[i].path.lexically_relative(bulkRoot), expected[i].path.lexically_relative(sequentialRoot)) << i;
+	}
+	ASSERT_EQ(results[1].path, bulkRoot + "c.txt");
+	ASSERT_EQ(results[3].error, std::errc::file_exists);
+	ASSERT_EQ(results[6].error, std::errc::invalid_argument);
+	ASSERT_EQ(results[10].path, bulkRoot + "e (2).txt");
+
+	// and the same files are left over
+	auto listing{ [](const std::string& root) {
+		std::set<std::filesystem::path> files;
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(root)) {
+			files.insert(entry.path().lexically_relative(root));
+		}
+		return files;
+	} };
+	ASSERT_EQ(listing(bulkRoot), listing(sequentialRoot));
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+	if (oldDataHome.empty()) {
+		unsetenv("XDG_DATA_HOME");
+	}
+	else {
+		setenv("XDG_DATA_HOME", oldDataHome.c_str(), 1);
+	}
+#endif
+}
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+TEST(FileOperationTests, TrashingInBulk)
+{
+	const std::string folder{ "test/trashing/" };
+	cleanFolder(folder);
+
+	// keep the test out of the real trash
+	std::filesystem::path dataHome{ std::filesystem::absolute(folder + "data home") };
+	std::string oldDataHome{ getenv("XDG_DATA_HOME") ? getenv("XDG_DATA_HOME") : "" };
+	setenv("XDG_DATA_HOME", dataHome.c_str(), 1);
+
+	std::vector<std::filesystem::path> paths;
+	for (int i{ 0 }; i < 50; i++) {
+		paths.push_back(folder + std::format("file {}.txt", i));
+		FileOperations::writeStringToFile("trash me", paths.back());
+	}
+	// same name twice, a whole folder, and something that isn't there
+	FileOperations::writeStringToFile("me too", folder + "other/file 0.txt");
+	paths.push_back(folder + "other/file 0.txt");
+	FileOperations::writeStringToFile("deep", folder + "big folder/a/b/c.txt");
+	paths.push_back(folder + "big folder/");
+	paths.push_back(folder + "missing.txt");
+
+	std::vector<std::error_code> errors{ FileOperations::sendToRecycleBin(paths) };
+	ASSERT_EQ(errors.size(), paths.size());
+	for (size_t i{ 0 }; i + 1 < paths.size(); i++) {
+		ASSERT_FALSE(errors[i]) << paths[i];
+		ASSERT_FALSE(std::filesystem::exists(paths[i]));
+	}
+	ASSERT_EQ(errors.back(), std::errc::no_such_file_or_directory);
+
+	std::filesystem::path trash{ dataHome / "Trash" };
+	ASSERT_TRUE(std::filesystem::exists(trash / "files/file 0.txt"));
+	ASSERT_TRUE(std::filesystem::exists(trash / "files/file 0 (2).txt"));
+	ASSERT_TRUE(std::filesystem::exists(trash / "files/big folder/a/b/c.txt"));
+	ASSERT_EQ(FileOperations::getAllFilesInFolder(trash / "info", ".trashinfo").size(), paths.size() - 1);
+
+	// the info file says where it came from, url escaped
+	FileOperations::FileContents info{ FileOperations::readFile(trash / "info/file 0 (2).txt.trashinfo") };
+	std::vector<std::string_view> lines{ FileOperations::readLines(info) };
+	ASSERT_EQ(lines.size(), 3);
+	ASSERT_EQ(lines[0], "[Trash Info]");
+	std::string expectedPath{ std::filesystem::absolute(folder + "other/file 0.txt").lexically_normal().string() };
+	size_t space{ 0 };
+	while ((space = expectedPath.find(' ', space)) != std::string::npos) {
+		expectedPath.replace(space, 1, "%20");
+	}
+	ASSERT_EQ(lines[1], "Path=" + expectedPath);
+	ASSERT_TRUE(lines[2].starts_with("DeletionDate="));
+
+	if (oldDataHome.empty()) {
+		unsetenv("XDG_DATA_HOME");
+	}
+	else {
+		setenv("XDG_DATA_HOME", oldDataHome.c_str(), 1);
+	}
+}
+#endif
 
 
 
@@ -0,0 +1,157 @@
+#include <algorithm>
+
+#include "Appender.h"
+#include "FileOperations.h"
+
+FileOperations::Appender::Appender(const std::filesystem::path& path, AppenderOptions options)
+	: m_options{ options }, m_head{ &m_stub }, m_tail{ &m_stub }
+{
+	FileOpHelpers::createFolder(path);
+
+	m_file.open(path, std::ios_base::app);
+	if (!m_file) {
+		throw std::filesystem::filesystem_error("cannot open file for appending", path, std::make_error_code(std::errc::io_error));
+	}
+
+	m_writer = std::thread{ &Appender::writerLoop, this };
+}
+
+FileOperations::Appender::~Appender()
+{
+	{
+		std::lock_guard lock{ m_mutex };
+		m_stopping = true;
+	}
+	m_wake.notify_one();
+	m_writer.join();
+
+	// the writer drained everything before it quit, but just in case a write failed partway
+	while (Node* node{ pop() }) {
+		delete node;
+	}
+}
+
+void FileOperations::Appender::push(Node* node)
+{
+	node->next.store(nullptr, std::memory_order_relaxed);
+	Node* prev{ m_head.exchange(node, std::memory_order_acq_rel) };
+	// between the exchange and this store, the writer can't see node yet. pop() knows about that gap
+	prev->next.store(node, std::memory_order_release);
+}
+
+FileOperations::Appender::Node* FileOperations::Appender::pop()
+{
+	Node* tail{ m_tail };
+	Node* next{ tail->next.load(std::memory_order_acquire) };
+
+	// skip over the stub. it's only there so the queue is never truly empty
+	if (tail == &m_stub) {
+		if (!next) {
+			return nullptr;
+		}
+		m_tail = next;
+		tail = next;
+		next = next->next.load(std::memory_order_acquire);
+	}
+
+	if (next) {
+		m_tail = next;
+		return tail;
+	}
+
+	// tail might be the last node, or a producer might be halfway through pushing after it
+	if (tail != m_head.load(std::memory_order_acquire)) {
+		return nullptr;
+	}
+
+	// it's the last node. put the stub back behind it so we can hand tail out without leaving the queue empty
+	push(&m_stub);
+	next = tail->next.load(std::memory_order_acquire);
+	if (next) {
+		m_tail = next;
+		return tail;
+	}
+	return nullptr;
+}
+
+void FileOperations::Appender::append(std::string_view line)
+{
+	Node* node{ new Node };
+	node->line.reserve(line.size() + 1);
+	node->line.append(line);
+	node->line += '\n';
+
+	size_t bytes{ node->line.size() };
+	push(node);
+	m_appended.fetch_add(1, std::memory_order_release);
+
+	// wake the writer early if enough has piled up. we don't take the lock here, so once in a while the writer misses
+	// this and waits out the rest of flushInterval instead, which is fine
+	if (m_pendingBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes >= m_options.flushBytes) {
+		m_wake.notify_one();
+	}
+}
+
+bool FileOperations::Appender::flush()
+{
+	uint64_t target{ m_appended.load(std::memory_order_acquire) };
+
+	std::unique_lock lock{ m_mutex };
+	m_flushTarget = std::max(m_flushTarget, target);
+	m_wake.notify_one();
+
+	m_flushed.wait(lock, [this, target] { return m_written.load() >= target || m_failed.load(); });
+
+	return !m_failed.load();
+}
+
+void FileOperations::Appender::drain()
+{
+	m_batch.clear();
+
+	uint64_t count{ 0 };
+	while (Node* node{ pop() }) {
+		m_batch += node->line;
+		delete node;
+		++count;
+	}
+
+	if (count == 0) {
+		return;
+	}
+
+	m_pendingBytes.fetch_sub(m_batch.size(), std::memory_order_relaxed);
+
+	// the whole batch goes out together. big batches skip the stream's buffer, and small ones get pushed out by flush()
+	m_file.write(m_batch.data(), static_cast<std::streamsize>(m_batch.size()));
+	m_file.flush();
+	if (!m_file) {
+		m_failed = true;
+	}
+
+	m_written.fetch_add(count, std::memory_order_release);
+}
+
+void FileOperations::Appender::writerLoop()
+{
+	std::unique_lock lock{ m_mutex };
+
+	while (true) {
+		m_wake.wait_for(lock, m_options.flushInterval, [this] {
+			return m_stopping
+				|| m_flushTarget > m_written.load()
+				|| m_pendingBytes.load(std::memory_order_relaxed) >= m_options.flushBytes;
+		});
+		bool stopping{ m_stopping };
+
+		lock.unlock();
+		drain();
+		lock.lock();
+
+		m_flushed.notify_all();
+
+		if (stopping && m_written.load() >= m_appended.load()) {
+			return;
+		}
+	}
+}
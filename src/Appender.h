@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace FileOperations
+{
+	struct AppenderOptions
+	{
+		// write as soon as this many bytes are waiting
+		size_t flushBytes{ 64 * 1024 };
+		// and never let a line sit around for longer than this
+		std::chrono::milliseconds flushInterval{ 100 };
+	};
+
+	// keeps a file open in append mode and writes lines to it from a background thread. use this instead of calling
+	// writeStringToFile(..., std::ios_base::app) in a loop, which opens, writes, flushes, and closes the file every time.
+	//
+	// any number of threads can call append() at once. lines go into a lock free queue, and the background thread
+	// writes them out in big batches, so a line never gets split up or mixed in with another one.
+	class Appender
+	{
+	public:
+		// creates the parent folders like writeStringToFile() does. throws filesystem_error if the file can't be opened
+		explicit Appender(const std::filesystem::path& path, AppenderOptions options = {});
+		// writes out anything that's still waiting
+		~Appender();
+
+		Appender(const Appender&) = delete;
+		Appender& operator=(const Appender&) = delete;
+
+		// queues up line + '\n'
+		void append(std::string_view line);
+
+		// blocks until every line appended before this call has been written. returns false if a write failed
+		bool flush();
+
+	private:
+		struct Node
+		{
+			std::atomic<Node*> next{ nullptr };
+			std::string line;
+		};
+
+		// multi producer, single consumer queue (dmitry vyukov's intrusive design). producers only ever touch m_head
+		// with a single exchange, and only the writer thread touches m_tail
+		void push(Node* node);
+		Node* pop();
+
+		void writerLoop();
+		// writes out everything that's in the queue right now
+		void drain();
+
+		std::ofstream m_file;
+		AppenderOptions m_options;
+
+		std::atomic<Node*> m_head;
+		Node* m_tail;
+		Node m_stub;
+
+		std::atomic<uint64_t> m_appended{ 0 };
+		std::atomic<uint64_t> m_written{ 0 };
+		std::atomic<size_t> m_pendingBytes{ 0 };
+		std::atomic<bool> m_failed{ false };
+
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::condition_variable m_flushed;
+		uint64_t m_flushTarget{ 0 };
+		bool m_stopping{ false };
+
+		// reused between batches, so we aren't allocating a new buffer every time
+		std::string m_batch;
+
+		std::thread m_writer;
+	};
+}
@@ -0,0 +1,369 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <format>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <system_error>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include "FileOperations.h"
+#include "PosixIO.h"
+
+namespace
+{
+	// the handful of platform specific steps an atomic write needs. everything else is shared
+
+#ifdef _WIN32
+	int openTemp(const std::filesystem::path& path)
+	{
+		// text mode, so the bytes match what writeStringToFile()'s ofstream writes
+		return _wopen(path.c_str(), _O_WRONLY | _O_CREAT | _O_EXCL | _O_TEXT, _S_IREAD | _S_IWRITE);
+	}
+
+	bool writeData(int fd, const char* data, size_t size)
+	{
+		while (size > 0) {
+			int written{ _write(fd, data, static_cast<unsigned int>(std::min<size_t>(size, 1 << 30))) };
+			if (written < 0) {
+				return false;
+			}
+			data += written;
+			size -= static_cast<size_t>(written);
+		}
+		return true;
+	}
+
+	bool writeString(int fd, const std::string& string)
+	{
+		return writeData(fd, string.data(), string.size()) && writeData(fd, "\n", 1);
+	}
+
+	bool writeStrings(int fd, const std::vector<std::string>& strings)
+	{
+		for (const std::string& s : strings) {
+			if (!writeString(fd, s)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void startWriteback(int) {}
+
+	bool syncFile(int fd, FileOperations::Durability durability)
+	{
+		return durability == FileOperations::Durability::None || _commit(fd) == 0;
+	}
+
+	void closeFile(int fd) { _close(fd); }
+
+	std::error_code replaceFile(const std::filesystem::path& from, const std::filesystem::path& to)
+	{
+		// write through makes the rename itself durable, which is what the folder fsync does on posix
+		if (MoveFileExW(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+			return {};
+		}
+		return { static_cast<int>(GetLastError()), std::system_category() };
+	}
+
+	bool syncFolder(const std::filesystem::path&) { return true; }
+
+	void removeFile(const std::filesystem::path& path) { _wunlink(path.c_str()); }
+
+	int processId() { return static_cast<int>(GetCurrentProcessId()); }
+#else
+	int openTemp(const std::filesystem::path& path)
+	{
+		return open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+	}
+
+	bool writeString(int fd, const std::string& string)
+	{
+		static char newline{ '\n' };
+		iovec iov[2]{ { const_cast<char*>(string.data()), string.size() }, { &newline, 1 } };
+		return FileOpHelpers::posix::writeAllV(fd, iov, 2);
+	}
+
+	bool writeStrings(int fd, const std::vector<std::string>& strings)
+	{
+		return FileOpHelpers::posix::writeLines(fd, strings);
+	}
+
+	void startWriteback([[maybe_unused]] int fd)
+	{
+#ifdef __linux__
+		// only starts the writeback, doesn't wait for it. doing this for a whole batch before waiting on any of them
+		// lets the disk work on all of them at once
+		sync_file_range(fd, 0, 0, SYNC_FILE_RANGE_WRITE);
+#endif
+	}
+
+	bool syncFile(int fd, FileOperations::Durability durability)
+	{
+		switch (durability) {
+		case FileOperations::Durability::None:
+			return true;
+		case FileOperations::Durability::DataSync:
+#if defined(__APPLE__)
+			return fsync(fd) == 0;
+#else
+			return fdatasync(fd) == 0;
+#endif
+		case FileOperations::Durability::FullSync:
+			return fsync(fd) == 0;
+		}
+		return false;
+	}
+
+	void closeFile(int fd) { close(fd); }
+
+	std::error_code replaceFile(const std::filesystem::path& from, const std::filesystem::path& to)
+	{
+		if (rename(from.c_str(), to.c_str()) == 0) {
+			return {};
+		}
+		return { errno, std::generic_category() };
+	}
+
+	bool syncFolder(const std::filesystem::path& folder)
+	{
+		FileOpHelpers::posix::FileDescriptor fd{ open(folder.empty() ? "." : folder.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC) };
+		return fd.fd >= 0 && fsync(fd.fd) == 0;
+	}
+
+	void removeFile(const std::filesystem::path& path) { unlink(path.c_str()); }
+
+	int processId() { return static_cast<int>(getpid()); }
+#endif
+
+	// one atomic write on its way to disk
+	struct PendingWrite
+	{
+		int fd{ -1 };
+		std::filesystem::path temp;
+		std::filesystem::path path;
+		FileOperations::Durability durability;
+		// whatever went wrong first. empty means it worked
+		std::error_code error;
+		bool done{ false };
+
+		// the crt functions all leave their reason in errno, on both platforms
+		void fail() { error.assign(errno ? errno : EIO, std::generic_category()); }
+	};
+
+	// writes the data to a fresh temp file in the same folder (rename only works within one file system)
+	bool prepare(PendingWrite& pending, const std::function<bool(int)>& write)
+	{
+		static std::atomic<uint64_t> counter{ 0 };
+
+		FileOpHelpers::createFolder(pending.path, false, pending.error);
+		if (pending.error) {
+			return false;
+		}
+
+		// the name is only there so you can tell whose temp file it is. the pid and counter are what make it unique, so
+		// a long name gets cut short instead of pushing the whole thing past the 255 bytes file systems allow
+		constexpr size_t longestExtras{ std::string_view{ "..2147483647.18446744073709551615.tmp" }.size() };
+		std::string name{ pending.path.filename().string() };
+		if (name.size() > 255 - longestExtras) {
+			size_t cut{ 255 - longestExtras };
+			// don't leave half of a utf-8 character at the end
+			while (cut > 0 && (static_cast<unsigned char>(name[cut]) & 0xC0) == 0x80) {
+				cut--;
+			}
+			name.resize(cut);
+		}
+
+		pending.temp = pending.path;
+		pending.temp.replace_filename(std::format(".{}.{}.{}.tmp",
+			name, processId(), counter.fetch_add(1, std::memory_order_relaxed)));
+
+		pending.fd = openTemp(pending.temp);
+		if (pending.fd < 0) {
+			pending.fail();
+			return false;
+		}
+
+#ifndef _WIN32
+		// keep the permissions of the file we're replacing, like truncating it in place would have
+		struct stat st;
+		if (stat(pending.path.c_str(), &st) == 0) {
+			fchmod(pending.fd, st.st_mode & 07777);
+		}
+#endif
+
+		if (!write(pending.fd)) {
+			pending.fail();
+			closeFile(pending.fd);
+			removeFile(pending.temp);
+			return false;
+		}
+		return true;
+	}
+
+	// sync, rename, and (for FullSync) sync the folders for a whole batch. the expensive waits happen once per batch
+	// instead of once per file
+	void commitBatch(const std::vector<PendingWrite*>& batch)
+	{
+		for (PendingWrite* pending : batch) {
+			if (pending->durability != FileOperations::Durability::None) {
+				startWriteback(pending->fd);
+			}
+		}
+
+		for (PendingWrite* pending : batch) {
+			errno = 0;
+			if (!syncFile(pending->fd, pending->durability)) {
+				pending->fail();
+			}
+			closeFile(pending->fd);
+			pending->fd = -1;
+
+			if (!pending->error) {
+				pending->error = replaceFile(pending->temp, pending->path);
+			}
+			if (pending->error) {
+				removeFile(pending->temp);
+			}
+		}
+
+		// lots of files going into the same folder only need that folder synced once. this is the only part that
+		// allocates, and it can't be allowed to throw: the group commit leader would never hand off, and everybody
+		// else would wait forever
+		try {
+			std::set<std::filesystem::path> folders;
+			for (PendingWrite* pending : batch) {
+				if (!pending->error && pending->durability == FileOperations::Durability::FullSync) {
+					folders.insert(pending->path.parent_path());
+				}
+			}
+			for (const std::filesystem::path& folder : folders) {
+				errno = 0;
+				if (!syncFolder(folder)) {
+					for (PendingWrite* pending : batch) {
+						if (!pending->error && pending->path.parent_path() == folder) {
+							pending->fail();
+						}
+					}
+				}
+			}
+		}
+		catch (...) {
+			// the files are in place, but there's no telling whether the renames made it to disk
+			std::error_code error{ FileOpHelpers::currentExceptionError() };
+			for (PendingWrite* pending : batch) {
+				if (!pending->error && pending->durability == FileOperations::Durability::FullSync) {
+					pending->error = error;
+				}
+			}
+		}
+	}
+
+	// leader/follower group commit. whoever shows up while nobody is syncing becomes the leader and syncs everything
+	// that's queued. everyone who shows up in the meantime waits and gets picked up by the next leader as one batch.
+	class GroupCommit
+	{
+	public:
+		void commit(PendingWrite& pending)
+		{
+			std::unique_lock lock{ m_mutex };
+			m_queue.push_back(&pending);
+
+			while (!pending.done) {
+				if (m_leaderActive) {
+					m_done.wait(lock);
+					continue;
+				}
+
+				m_leaderActive = true;
+				std::vector<PendingWrite*> batch;
+				batch.swap(m_queue);
+
+				lock.unlock();
+				commitBatch(batch);
+				lock.lock();
+
+				for (PendingWrite* p : batch) {
+					p->done = true;
+				}
+				m_leaderActive = false;
+				m_done.notify_all();
+			}
+		}
+
+	private:
+		std::mutex m_mutex;
+		std::condition_variable m_done;
+		std::vector<PendingWrite*> m_queue;
+		bool m_leaderActive{ false };
+	};
+
+	// can only throw before the temp file exists, so the callers just have to catch
+	bool writeAtomic(const std::filesystem::path& path, const FileOperations::AtomicWriteOptions& options, const std::function<bool(int)>& write, std::error_code& ec)
+	{
+		PendingWrite pending;
+		pending.path = path;
+		pending.durability = options.durability;
+
+		if (prepare(pending, write)) {
+			if (options.groupCommit) {
+				static GroupCommit group;
+				group.commit(pending);
+			}
+			else {
+				commitBatch({ &pending });
+			}
+		}
+
+		ec = pending.error;
+		return !ec;
+	}
+}
+
+bool FileOperations::writeStringToFileAtomic(const std::string& string, const std::filesystem::path& path, const AtomicWriteOptions& options)
+{
+	std::error_code ec;
+	return writeStringToFileAtomic(string, path, options, ec);
+}
+
+bool FileOperations::writeStringsToFileAtomic(const std::vector<std::string>& strings, const std::filesystem::path& path, const AtomicWriteOptions& options)
+{
+	std::error_code ec;
+	return writeStringsToFileAtomic(strings, path, options, ec);
+}
+
+bool FileOperations::writeStringToFileAtomic(const std::string& string, const std::filesystem::path& path, const AtomicWriteOptions& options, std::error_code& ec) noexcept
+{
+	try {
+		return writeAtomic(path, options, [&string](int fd) { return writeString(fd, string); }, ec);
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+	}
+	return false;
+}
+
+bool FileOperations::writeStringsToFileAtomic(const std::vector<std::string>& strings, const std::filesystem::path& path, const AtomicWriteOptions& options, std::error_code& ec) noexcept
+{
+	try {
+		return writeAtomic(path, options, [&strings](int fd) { return writeStrings(fd, strings); }, ec);
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+	}
+	return false;
+}
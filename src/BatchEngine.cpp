@@ -0,0 +1,459 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <mutex>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include "BatchEngine.h"
+#include "PosixIO.h"
+#include "ThreadPool.h"
+
+struct FileOperations::BatchEngine::Job
+{
+	enum class Type { Write, Copy };
+
+	size_t id;
+	Type type;
+	std::filesystem::path path;
+	// write: the string to write. copy: unused
+	std::string data;
+
+#ifdef __linux__
+	// the ring reads these after we've submitted, so they have to live as long as the job does
+	iovec iov[2];
+	int slot{ -1 };
+	int openResult{ 0 };
+	int writeResult{ 0 };
+	int remaining{ 0 };
+#endif
+};
+
+#ifdef __linux__
+
+// bare bones io_uring, straight on top of the syscalls (no liburing). just enough for this engine: one submission
+// queue, one completion queue, and a table of registered ("direct") file slots.
+class FileOperations::BatchEngine::Ring
+{
+public:
+	~Ring()
+	{
+		if (m_sqes) munmap(m_sqes, m_sqesSize);
+		if (m_cqRing && m_cqRing != m_sqRing) munmap(m_cqRing, m_cqRingSize);
+		if (m_sqRing) munmap(m_sqRing, m_sqRingSize);
+		if (m_fd >= 0) close(m_fd);
+	}
+
+	// returns false if io_uring isn't there (old kernel, or blocked by seccomp/container policy)
+	bool init(unsigned int entries, unsigned int fileSlots)
+	{
+		io_uring_params params;
+		std::memset(&params, 0, sizeof(params));
+
+		m_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+		if (m_fd < 0) {
+			return false;
+		}
+
+		m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+		m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+		// newer kernels put both rings in one mapping
+		bool singleMap{ (params.features & IORING_FEAT_SINGLE_MMAP) != 0 };
+		if (singleMap) {
+			m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+		}
+
+		m_sqRing = map(m_sqRingSize, IORING_OFF_SQ_RING);
+		if (!m_sqRing) {
+			return false;
+		}
+		m_cqRing = singleMap ? m_sqRing : map(m_cqRingSize, IORING_OFF_CQ_RING);
+		if (!m_cqRing) {
+			return false;
+		}
+		m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+		m_sqes = static_cast<io_uring_sqe*>(map(m_sqesSize, IORING_OFF_SQES));
+		if (!m_sqes) {
+			return false;
+		}
+
+		char* sq{ static_cast<char*>(m_sqRing) };
+		m_sqHead = reinterpret_cast<unsigned int*>(sq + params.sq_off.head);
+		m_sqTail = reinterpret_cast<unsigned int*>(sq + params.sq_off.tail);
+		m_sqMask = *reinterpret_cast<unsigned int*>(sq + params.sq_off.ring_mask);
+		m_sqArray = reinterpret_cast<unsigned int*>(sq + params.sq_off.array);
+		m_sqEntries = params.sq_entries;
+		m_sqLocalTail = *m_sqTail;
+		m_sqSubmitted = m_sqLocalTail;
+
+		char* cq{ static_cast<char*>(m_cqRing) };
+		m_cqHead = reinterpret_cast<unsigned int*>(cq + params.cq_off.head);
+		m_cqTail = reinterpret_cast<unsigned int*>(cq + params.cq_off.tail);
+		m_cqMask = *reinterpret_cast<unsigned int*>(cq + params.cq_off.ring_mask);
+		m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+		// empty slots for direct descriptors. open puts the file in a slot, write uses the slot, close empties it, so the
+		// three can be chained without us ever seeing a real fd
+		std::vector<int> slots(fileSlots, -1);
+		if (syscall(__NR_io_uring_register, m_fd, IORING_REGISTER_FILES, slots.data(), fileSlots) < 0) {
+			return false;
+		}
+
+		return true;
+	}
+
+	unsigned int freeEntries() const
+	{
+		unsigned int head{ std::atomic_ref<unsigned int>(*m_sqHead).load(std::memory_order_acquire) };
+		return m_sqEntries - (m_sqLocalTail - head);
+	}
+
+	// zeroed entry at the end of the queue. only valid if freeEntries() said there's room
+	io_uring_sqe* nextEntry()
+	{
+		unsigned int idx{ m_sqLocalTail & m_sqMask };
+		m_sqArray[idx] = idx;
+		++m_sqLocalTail;
+
+		io_uring_sqe* sqe{ &m_sqes[idx] };
+		std::memset(sqe, 0, sizeof(*sqe));
+		return sqe;
+	}
+
+	// hands everything queued up to the kernel, and waits for at least waitFor completions. returns -errno on failure
+	int submit(unsigned int waitFor)
+	{
+		std::atomic_ref<unsigned int>(*m_sqTail).store(m_sqLocalTail, std::memory_order_release);
+
+		while (true) {
+			unsigned int toSubmit{ m_sqLocalTail - m_sqSubmitted };
+			long result{ syscall(__NR_io_uring_enter, m_fd, toSubmit, waitFor, waitFor ? IORING_ENTER_GETEVENTS : 0, nullptr, 0) };
+			if (result < 0) {
+				if (errno == EINTR) continue;
+				return -errno;
+			}
+			m_sqSubmitted += static_cast<unsigned int>(result);
+			return 0;
+		}
+	}
+
+	template <typename F>
+	void reap(F&& onCompletion)
+	{
+		unsigned int head{ *m_cqHead };
+		unsigned int tail{ std::atomic_ref<unsigned int>(*m_cqTail).load(std::memory_order_acquire) };
+
+		for (; head != tail; ++head) {
+			const io_uring_cqe& cqe{ m_cqes[head & m_cqMask] };
+			onCompletion(cqe.user_data, cqe.res);
+		}
+
+		std::atomic_ref<unsigned int>(*m_cqHead).store(head, std::memory_order_release);
+	}
+
+private:
+	void* map(size_t size, off_t offset)
+	{
+		void* ptr{ mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, offset) };
+		return ptr == MAP_FAILED ? nullptr : ptr;
+	}
+
+	int m_fd{ -1 };
+
+	void* m_sqRing{ nullptr };
+	size_t m_sqRingSize{ 0 };
+	void* m_cqRing{ nullptr };
+	size_t m_cqRingSize{ 0 };
+	io_uring_sqe* m_sqes{ nullptr };
+	size_t m_sqesSize{ 0 };
+
+	unsigned int* m_sqHead{ nullptr };
+	unsigned int* m_sqTail{ nullptr };
+	unsigned int* m_sqArray{ nullptr };
+	unsigned int m_sqMask{ 0 };
+	unsigned int m_sqEntries{ 0 };
+	unsigned int m_sqLocalTail{ 0 };
+	unsigned int m_sqSubmitted{ 0 };
+
+	unsigned int* m_cqHead{ nullptr };
+	unsigned int* m_cqTail{ nullptr };
+	unsigned int m_cqMask{ 0 };
+	io_uring_cqe* m_cqes{ nullptr };
+};
+
+#else
+
+// no io_uring outside of linux. everything goes through the thread pool
+class FileOperations::BatchEngine::Ring
+{
+};
+
+#endif
+
+FileOperations::BatchEngine::BatchEngine(BatchOptions options)
+	: m_options{ options }
+{
+#ifdef __linux__
+	if (m_options.useIoUring) {
+		// at least one whole open -> write -> close chain has to fit
+		unsigned int entries{ std::max(m_options.queueDepth, 4u) };
+		auto ring{ std::make_unique<Ring>() };
+		if (ring->init(entries, std::max(entries / 3, 1u))) {
+			m_ring = std::move(ring);
+		}
+	}
+#endif
+}
+
+FileOperations::BatchEngine::~BatchEngine() = default;
+
+bool FileOperations::BatchEngine::usingIoUring() const
+{
+	return m_ring != nullptr;
+}
+
+size_t FileOperations::BatchEngine::submitWrite(const std::filesystem::path& path, std::string string)
+{
+	auto job{ std::make_unique<Job>() };
+	job->id = m_nextId++;
+	job->type = Job::Type::Write;
+	job->path = path;
+	job->data = std::move(string);
+
+	m_jobs.push_back(std::move(job));
+	return m_jobs.back()->id;
+}
+
+size_t FileOperations::BatchEngine::submitCopy(const std::filesystem::path& path)
+{
+	auto job{ std::make_unique<Job>() };
+	job->id = m_nextId++;
+	job->type = Job::Type::Copy;
+	job->path = path;
+
+	m_jobs.push_back(std::move(job));
+	return m_jobs.back()->id;
+}
+
+std::vector<FileOperations::BatchCompletion> FileOperations::BatchEngine::run()
+{
+	std::vector<BatchCompletion> completions;
+	completions.reserve(m_jobs.size());
+
+	std::vector<Job*> ringJobs;
+	std::vector<Job*> poolJobs;
+	for (const auto& job : m_jobs) {
+		if (job->type == Job::Type::Write && m_ring) {
+			ringJobs.push_back(job.get());
+		}
+		else {
+			poolJobs.push_back(job.get());
+		}
+	}
+
+	if (!ringJobs.empty()) {
+		// anything the ring couldn't handle (like a kernel that's too old for direct descriptors) gets another shot on
+		// the thread pool
+		runOnRing(ringJobs, completions, poolJobs);
+	}
+	if (!poolJobs.empty()) {
+		runOnPool(poolJobs, completions);
+	}
+
+	m_jobs.clear();
+
+	return completions;
+}
+
+void FileOperations::BatchEngine::runOnPool(std::vector<Job*>& jobs, std::vector<BatchCompletion>& completions)
+{
+	FileOpHelpers::ThreadPool pool{ m_options.threadCount };
+	std::mutex completionsMutex;
+
+	for (Job* job : jobs) {
+		pool.submit([job, &completions, &completionsMutex] {
+			BatchCompletion completion{ job->id, true, {}, job->path };
+
+			if (job->type == Job::Type::Write) {
+				writeStringToFile(job->data, job->path, completion.error);
+			}
+			else {
+				CopyResult copied{ copyFile(job->path, completion.error) };
+				if (!completion.error) {
+					completion.path = copied.destination;
+				}
+			}
+			completion.ok = !completion.error;
+
+			std::lock_guard lock{ completionsMutex };
+			completions.push_back(std::move(completion));
+		});
+	}
+
+	pool.wait();
+}
+
+#ifdef __linux__
+void FileOperations::BatchEngine::runOnRing(std::vector<Job*>& jobs, std::vector<BatchCompletion>& completions, std::vector<Job*>& retry)
+{
+	// user_data is the job's position in jobs, with the step (0 open, 1 write, 2 close) in the low bits
+	constexpr uint64_t stepBits{ 2 };
+
+	std::vector<int> freeSlots;
+	for (int i{ static_cast<int>(std::max(std::max(m_options.queueDepth, 4u) / 3, 1u)) - 1 }; i >= 0; --i) {
+		freeSlots.push_back(i);
+	}
+
+	auto finish{ [&](Job& job) {
+		BatchCompletion completion{ job.id, true, {}, job.path };
+		size_t total{ job.data.size() + 1 };
+
+		if (job.openResult == -EINVAL || job.openResult == -EOPNOTSUPP || job.openResult == -ENOENT) {
+			// probably a kernel without direct descriptor support, or the folder went away after we opened it (which
+			// writeStringToFile() knows how to deal with). let the plain path have a go
+			retry.push_back(&job);
+			return;
+		}
+		if (job.openResult < 0) {
+			completion.ok = false;
+			completion.error = std::error_code(-job.openResult, std::generic_category());
+		}
+		else if (job.writeResult < 0) {
+			completion.ok = false;
+			completion.error = std::error_code(-job.writeResult, std::generic_category());
+		}
+		else if (static_cast<size_t>(job.writeResult) < total) {
+			// short write. practically never happens for regular files, but if it does just write the whole thing again
+			FileOpHelpers::posix::FileDescriptor fd{ open(job.path.c_str(), O_WRONLY | O_TRUNC | O_CLOEXEC) };
+			iovec iov[2]{ job.iov[0], job.iov[1] };
+			if (fd.fd < 0 || !FileOpHelpers::posix::writeAllV(fd.fd, iov, 2)) {
+				completion.ok = false;
+				completion.error = std::error_code(errno, std::generic_category());
+			}
+		}
+
+		completions.push_back(std::move(completion));
+	} };
+
+	static char newline{ '\n' };
+	struct OpenFolder
+	{
+		FileOpHelpers::posix::FileDescriptor fd;
+		std::error_code error;
+	};
+	std::map<std::string, OpenFolder, std::less<>> folders;
+	auto openFolder{ [](const std::filesystem::path& path) {
+		OpenFolder folder;
+		FileOpHelpers::createFolder(path, false, folder.error);
+		if (!folder.error) {
+			std::filesystem::path parent{ path.parent_path() };
+			folder.fd.reset(open(parent.empty() ? "." : parent.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC));
+			if (folder.fd.fd < 0) {
+				folder.error = FileOpHelpers::posix::lastError();
+			}
+		}
+		return folder;
+	} };
+
+	size_t next{ 0 };
+	size_t inFlight{ 0 };
+	while (next < jobs.size() || inFlight > 0) {
+
+		// queue up as many whole chains as we have room (and file slots) for
+		while (next < jobs.size() && !freeSlots.empty() && m_ring->freeEntries() >= 3) {
+			Job& job{ *jobs[next] };
+			uint64_t userData{ static_cast<uint64_t>(next) << stepBits };
+
+			// the folder gets made (same as writeStringToFile() would) and opened once per run. every open after that only
+			// has to look up the file name inside of it, instead of walking the whole path again
+			std::string_view native{ job.path.native() };
+			size_t slash{ native.rfind('/') };
+			std::string_view folderName{ slash == std::string_view::npos ? std::string_view{} : native.substr(0, slash + 1) };
+			auto folder{ folders.find(folderName) };
+			if (folder == folders.end()) {
+				folder = folders.emplace(std::string{ folderName }, openFolder(job.path)).first;
+			}
+			if (folder->second.error) {
+				completions.push_back({ job.id, false, folder->second.error, job.path });
+				++next;
+				continue;
+			}
+
+			job.slot = freeSlots.back();
+			freeSlots.pop_back();
+			job.remaining = 3;
+			job.iov[0] = { job.data.data(), job.data.size() };
+			job.iov[1] = { &newline, 1 };
+
+			// no O_CLOEXEC, the kernel refuses it for direct descriptors (they're never in the fd table anyway)
+			io_uring_sqe* open{ m_ring->nextEntry() };
+			open->opcode = IORING_OP_OPENAT;
+			open->fd = folder->second.fd.fd;
+			open->addr = reinterpret_cast<uint64_t>(job.path.c_str() + folderName.size());
+			open->len = 0666;
+			open->open_flags = O_WRONLY | O_CREAT | O_TRUNC;
+			open->file_index = static_cast<uint32_t>(job.slot) + 1;
+			// if the open fails, the rest of the chain gets cancelled
+			open->flags = IOSQE_IO_LINK;
+			open->user_data = userData | 0;
+
+			io_uring_sqe* write{ m_ring->nextEntry() };
+			write->opcode = IORING_OP_WRITEV;
+			write->fd = job.slot;
+			write->addr = reinterpret_cast<uint64_t>(job.iov);
+			write->len = 2;
+			write->off = 0;
+			// hard link, so the close still runs if the write fails. otherwise the file would be stuck in its slot
+			write->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+			write->user_data = userData | 1;
+
+			io_uring_sqe* close{ m_ring->nextEntry() };
+			close->opcode = IORING_OP_CLOSE;
+			close->file_index = static_cast<uint32_t>(job.slot) + 1;
+			close->user_data = userData | 2;
+
+			++next;
+			++inFlight;
+		}
+
+		if (inFlight == 0) {
+			continue;
+		}
+
+		// EBUSY/EAGAIN just mean the completion queue is full, which reaping below takes care of
+		int result{ m_ring->submit(1) };
+		if (result < 0 && result != -EBUSY && result != -EAGAIN) {
+			throw std::system_error(-result, std::generic_category(), "io_uring_enter failed");
+		}
+
+		m_ring->reap([&](uint64_t userData, int res) {
+			Job& job{ *jobs[userData >> stepBits] };
+			switch (userData & ((1 << stepBits) - 1)) {
+			case 0: job.openResult = res; break;
+			case 1: job.writeResult = res; break;
+			default: break;
+			}
+
+			if (--job.remaining == 0) {
+				freeSlots.push_back(job.slot);
+				--inFlight;
+				finish(job);
+			}
+		});
+	}
+}
+#else
+void FileOperations::BatchEngine::runOnRing(std::vector<Job*>& jobs, std::vector<BatchCompletion>&, std::vector<Job*>& retry)
+{
+	retry.insert(retry.end(), jobs.begin(), jobs.end());
+}
+#endif
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "FileOperations.h"
+
+namespace FileOperations
+{
+	struct BatchOptions
+	{
+		// io_uring submission queue size. every file write takes 3 entries (open, write, close), so this allows
+		// queueDepth / 3 files in flight at once
+		unsigned int queueDepth{ 256 };
+		// threads for copies, and for everything if io_uring isn't available. 0 means use every core
+		unsigned int threadCount{ 0 };
+		// set to false to always use the thread pool
+		bool useIoUring{ true };
+	};
+
+	struct BatchCompletion
+	{
+		// what submitWrite()/submitCopy() returned
+		size_t id;
+		bool ok;
+		std::error_code error;
+		// the file that was written, or where the copy ended up
+		std::filesystem::path path;
+	};
+
+	// writes and copies a lot of small files at once. on linux, writes go through io_uring as linked open -> write ->
+	// close chains, so thousands of files cost a handful of syscalls instead of three each, and every file is opened
+	// relative to its folder (made and opened once per run) instead of by its whole path. copies (and writes, when
+	// io_uring isn't available) run on a thread pool instead.
+	//
+	//	FileOperations::BatchEngine batch;
+	//	for (...) batch.submitWrite(path, contents);
+	//	for (const auto& done : batch.run()) { ... }
+	class BatchEngine
+	{
+	public:
+		explicit BatchEngine(BatchOptions options = {});
+		~BatchEngine();
+
+		BatchEngine(const BatchEngine&) = delete;
+		BatchEngine& operator=(const BatchEngine&) = delete;
+
+		// same result as writeStringToFile(string, path): the file gets replaced with string + '\n'
+		size_t submitWrite(const std::filesystem::path& path, std::string string);
+
+		// same result as copyFile(path). the destination name is reserved when the copy actually runs, so copies of the
+		// same file in one batch (or files made in the meantime) never end up fighting over one name
+		size_t submitCopy(const std::filesystem::path& path);
+
+		// does everything submitted since the last run(). completions come back in the order they finished
+		std::vector<BatchCompletion> run();
+
+		bool usingIoUring() const;
+
+	private:
+		struct Job;
+		class Ring;
+
+		void runOnPool(std::vector<Job*>& jobs, std::vector<BatchCompletion>& completions);
+		void runOnRing(std::vector<Job*>& jobs, std::vector<BatchCompletion>& completions, std::vector<Job*>& retry);
+
+		BatchOptions m_options;
+		std::unique_ptr<Ring> m_ring;
+		std::vector<std::unique_ptr<Job>> m_jobs;
+		size_t m_nextId{ 0 };
+	};
+}
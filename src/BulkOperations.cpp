@@ -0,0 +1,288 @@
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+#include "BulkOperations.h"
+#include "FileOperations.h"
+#include "ThreadPool.h"
+
+namespace
+{
+	// how many operations in the same folder one thread gets at a time. enough that a thread stays in one folder for a
+	// while, few enough that one huge folder still gets spread around
+	constexpr size_t groupSize{ 64 };
+
+	// whether there's a "." or ".." or an empty part (like in "a//b") anywhere in path
+	bool needsNormalizing(std::string_view path)
+	{
+		size_t begin{ path.find_first_not_of('/') };
+		while (begin < path.size()) {
+			size_t end{ std::min(path.find('/', begin), path.size()) };
+			std::string_view part{ path.substr(begin, end - begin) };
+			if (part.empty() || part == "." || part == "..") {
+				return true;
+			}
+			begin = end + 1;
+		}
+		return false;
+	}
+
+	// what a path gets compared as. absolute, so "a.txt" and "./a.txt" are the same file
+	std::string keyOf(const std::filesystem::path& path)
+	{
+		std::error_code ec;
+		std::filesystem::path absolute{ std::filesystem::absolute(path, ec) };
+		std::string key{ (ec ? path : absolute).generic_string() };
+		// lexically_normal() costs more than everything else put together, and plans are nearly always made of
+		// paths that are already normal
+		if (needsNormalizing(key)) {
+			key = std::filesystem::path{ key }.lexically_normal().generic_string();
+		}
+		// "folder/" is the folder
+		if (key.size() > 1 && key.back() == '/') {
+			key.pop_back();
+		}
+		return key;
+	}
+
+	// every folder above key
+	void addFolders(std::string_view key, std::vector<std::string_view>& keys)
+	{
+		for (size_t slash{ key.find('/', 1) }; slash != std::string_view::npos; slash = key.find('/', slash + 1)) {
+			keys.push_back(key.substr(0, slash));
+		}
+	}
+
+	// so the maps can be searched with a string_view, without making a string out of it first
+	struct KeyHash
+	{
+		using is_transparent = void;
+		size_t operator()(std::string_view key) const { return std::hash<std::string_view>{}(key); }
+	};
+
+	template <typename Value>
+	using KeyMap = std::unordered_map<std::string, Value, KeyHash, std::equal_to<>>;
+
+	// works out which round each operation can run in. an operation "writes" the paths it creates, moves, or removes,
+	// and "reads" the ones it only needs to be there. it has to come after the last earlier operation that wrote
+	// anything it touches, and after every earlier one that read something it writes. two that only read the same
+	// thing can share a round
+	class Planner
+	{
+	public:
+		size_t add(const std::vector<std::string_view>& writes, const std::vector<std::string_view>& reads)
+		{
+			size_t round{ 0 };
+			auto after{ [&](const KeyMap<size_t>& rounds, std::string_view key) {
+				auto it{ rounds.find(key) };
+				if (it != rounds.end()) {
+					round = std::max(round, it->second + 1);
+				}
+			} };
+
+			for (std::string_view key : reads) {
+				after(m_lastWrite, key);
+			}
+			for (std::string_view key : writes) {
+				after(m_lastWrite, key);
+				after(m_lastRead, key);
+			}
+
+			for (std::string_view key : reads) {
+				set(m_lastRead, key, round);
+			}
+			for (std::string_view key : writes) {
+				set(m_lastWrite, key, round);
+			}
+			return round;
+		}
+
+	private:
+		// rounds only ever go up for a key, so this is also the max
+		static void set(KeyMap<size_t>& rounds, std::string_view key, size_t round)
+		{
+			auto it{ rounds.find(key) };
+			if (it == rounds.end()) {
+				rounds.emplace(key, round);
+			}
+			else {
+				it->second = std::max(it->second, round);
+			}
+		}
+
+		KeyMap<size_t> m_lastWrite;
+		KeyMap<size_t> m_lastRead;
+	};
+
+	void runGroup(std::span<const FileOperations::BulkOperation> plan, std::span<const size_t> group, std::vector<FileOperations::BulkResult>& results)
+	{
+		// the trashes get done together at the end, so the trash folder only gets looked up once
+		std::vector<std::filesystem::path> trashed;
+		std::vector<size_t> trashedIndexes;
+
+		for (size_t i : group) {
+			const FileOperations::BulkOperation& operation{ plan[i] };
+			FileOperations::BulkResult& result{ results[i] };
+
+			switch (operation.action) {
+			case FileOperations::BulkAction::Rename:
+				result.ok = FileOperations::renameFile(operation.path, operation.newName, result.error);
+				if (result.ok) {
+					result.path = FileOpHelpers::renamePath(operation.path, operation.newName);
+				}
+				break;
+			case FileOperations::BulkAction::Copy:
+				result.path = FileOperations::copyFile(operation.path, result.error).destination;
+				result.ok = !result.error;
+				break;
+			case FileOperations::BulkAction::Delete:
+				result.ok = FileOperations::deleteFile(operation.path, result.error);
+				if (!result.error) {
+					result.path = operation.path;
+				}
+				break;
+			case FileOperations::BulkAction::Trash:
+				trashed.push_back(operation.path);
+				trashedIndexes.push_back(i);
+				break;
+			}
+		}
+
+		if (trashed.empty()) {
+			return;
+		}
+		std::vector<std::error_code> errors{ FileOperations::sendToRecycleBin(trashed) };
+		for (size_t j{ 0 }; j < trashed.size(); j++) {
+			FileOperations::BulkResult& result{ results[trashedIndexes[j]] };
+			result.error = errors[j];
+			result.ok = !errors[j];
+			if (result.ok) {
+				result.path = std::move(trashed[j]);
+			}
+		}
+	}
+}
+
+std::vector<FileOperations::BulkResult> FileOperations::runBulkOperations(std::span<const BulkOperation> plan, const BulkOptions& options)
+{
+	std::vector<BulkResult> results(plan.size());
+
+	// plan everything before touching anything
+	Planner planner;
+	std::vector<std::vector<size_t>> rounds;
+	// which folder each operation happens in, as an index into folderIds
+	std::vector<uint32_t> folders(plan.size());
+	KeyMap<uint32_t> folderIds;
+
+	// reused for every operation, so planning doesn't allocate much once they've grown
+	std::string family;
+	std::string newKey;
+	std::string newFamily;
+	std::vector<std::string_view> writes;
+	std::vector<std::string_view> reads;
+
+	// "name (n)" and "name" are the same family. copies pick their number out of it, and renames check it
+	auto familyOf{ [](std::string_view key, std::string& buffer) {
+		FileOpHelpers::SuffixSplit split{ FileOpHelpers::splitSuffix(key) };
+		if (!split.found) {
+			return key;
+		}
+		buffer.assign(split.head).append(split.tail);
+		return std::string_view{ buffer };
+	} };
+
+	for (size_t i{ 0 }; i < plan.size(); i++) {
+		const BulkOperation& operation{ plan[i] };
+
+		// renameFile() would turn it down without touching anything, so it doesn't need a round either
+		if (operation.action == BulkAction::Rename && FileOpHelpers::filenameHasIllegalChar(operation.newName)) {
+			results[i].error = std::make_error_code(std::errc::invalid_argument);
+			continue;
+		}
+
+		std::string key{ keyOf(operation.path) };
+
+		writes.clear();
+		reads.clear();
+		addFolders(key, reads);
+
+		switch (operation.action) {
+		case BulkAction::Rename:
+			// renamePath() keeps the extension, which is never longer than the whole key
+			newKey.resize(key.size() * 2 + operation.newName.size());
+			newKey.resize(FileOpHelpers::renamePath(key, operation.newName, newKey).size());
+			writes.insert(writes.end(), { key, familyOf(key, family), newKey, familyOf(newKey, newFamily) });
+			break;
+		case BulkAction::Copy:
+			// the copy lands somewhere in the family. the original only has to be there
+			reads.push_back(key);
+			writes.push_back(familyOf(key, family));
+			break;
+		case BulkAction::Delete:
+		case BulkAction::Trash:
+			writes.insert(writes.end(), { key, familyOf(key, family) });
+			break;
+		}
+
+		size_t round{ planner.add(writes, reads) };
+		if (round >= rounds.size()) {
+			rounds.resize(round + 1);
+		}
+		rounds[round].push_back(i);
+
+		std::string_view folder{ std::string_view{ key }.substr(0, std::min(key.find_last_of('/'), key.size())) };
+		auto it{ folderIds.find(folder) };
+		if (it == folderIds.end()) {
+			it = folderIds.emplace(folder, static_cast<uint32_t>(folderIds.size())).first;
+		}
+		folders[i] = it->second;
+	}
+
+	// the pool only gets started once a round actually has something to spread around, so small plans and plans that
+	// are all one folder never pay for starting threads. one thread (or not being able to start any) means everything
+	// runs on this one
+	unsigned int threadCount{ options.threadCount != 0 ? options.threadCount : std::thread::hardware_concurrency() };
+	std::unique_ptr<FileOpHelpers::ThreadPool> pool;
+	bool poolFailed{ threadCount <= 1 };
+
+	std::vector<std::span<const size_t>> groups;
+	for (std::vector<size_t>& round : rounds) {
+		// nothing in a round depends on anything else in it, so they can go in any order. folder by folder
+		std::stable_sort(round.begin(), round.end(), [&](size_t a, size_t b) { return folders[a] < folders[b]; });
+
+		groups.clear();
+		for (size_t begin{ 0 }; begin < round.size();) {
+			size_t end{ begin + 1 };
+			while (end < round.size() && end - begin < groupSize && folders[round[end]] == folders[round[begin]]) {
+				end++;
+			}
+			groups.push_back(std::span<const size_t>{ round }.subspan(begin, end - begin));
+			begin = end;
+		}
+
+		if (!pool && !poolFailed && groups.size() > 1) {
+			try {
+				pool = std::make_unique<FileOpHelpers::ThreadPool>(threadCount);
+			}
+			catch (const std::system_error&) {
+				poolFailed = true;
+			}
+		}
+
+		if (pool && groups.size() > 1) {
+			FileOpHelpers::parallelFor(*pool, groups.size(), [&](size_t g) { runGroup(plan, groups[g], results); });
+		}
+		else {
+			for (std::span<const size_t> group : groups) {
+				runGroup(plan, group, results);
+			}
+		}
+	}
+
+	return results;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <filesystem>
+#include <span>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace FileOperations
+{
+	enum class BulkAction
+	{
+		Rename,  // renameFile(path, newName)
+		Copy,    // copyFile(path)
+		Delete,  // deleteFile(path)
+		Trash,   // sendToRecycleBin(path)
+	};
+
+	struct BulkOperation
+	{
+		BulkAction action;
+		std::filesystem::path path;
+		// only for Rename. same as renameFile()'s: just the name, no folder and no extension
+		std::string newName{};
+	};
+
+	struct BulkResult
+	{
+		// what the single version would've returned. for Delete that's false if there was nothing to delete, with no
+		// error, same as deleteFile()
+		bool ok{ false };
+		// same errors as the single versions. a Rename with an illegal newName is errc::invalid_argument, and never
+		// touches the disk
+		std::error_code error;
+		// Rename: the new path. Copy: where the copy went. Delete and Trash: the path. empty if it failed
+		std::filesystem::path path;
+	};
+
+	struct BulkOptions
+	{
+		// 0 means use every core. threads only get started if some round has more than one folder's worth of work in it
+		unsigned int threadCount{ 0 };
+	};
+
+	// runs a whole plan of renames, copies, deletes, and trashes, and gives back one result per operation, in the same
+	// order as plan. the results (and the files left behind) are the same as calling the single versions one after
+	// the other in plan order, but everything that doesn't depend on something else runs at the same time.
+	//
+	// before anything runs, every rename's new name gets checked, and the plan gets split into rounds. an operation
+	// waits for an earlier one if they touch the same path, the same "name (n)" family (so copies still get their
+	// numbers in plan order, and a rename onto a name that an earlier operation frees up or takes still sees it that
+	// way), or if the earlier one moves or removes a folder the later one is inside of. so chains (b -> c, then a -> b)
+	// work, and a swap fails the same way it would one at a time. within a round, operations in the same folder are
+	// handed to the same thread together, since the file system locks the folder for every one of them anyway.
+	//
+	// paths are compared as written (made absolute), so two different paths to the same file through a symlink count as
+	// different files.
+	//
+	// the win from running rounds on several threads hasn't been measured yet: the benchmarks so far only ran on a
+	// single core machine, where this is about as fast as the one at a time loop. so treat any speed up from more
+	// cores as unverified.
+	//
+	//	std::vector<FileOperations::BulkOperation> plan;
+	//	plan.push_back({ FileOperations::BulkAction::Rename, "logs/today.txt", "yesterday" });
+	//	plan.push_back({ FileOperations::BulkAction::Trash, "logs/last week.txt" });
+	//	auto results{ FileOperations::runBulkOperations(plan) };
+	std::vector<BulkResult> runBulkOperations(std::span<const BulkOperation> plan, const BulkOptions& options = {});
+}
@@ -0,0 +1,380 @@
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <initializer_list>
+#include <tuple>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Duplicates.h"
+#include "PosixIO.h"
+#include "ThreadPool.h"
+
+uint64_t FileOpHelpers::hash64(const void* data, size_t size, uint64_t seed)
+{
+	// https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+	constexpr uint64_t prime1{ 0x9E3779B185EBCA87ull };
+	constexpr uint64_t prime2{ 0xC2B2AE3D27D4EB4Full };
+	constexpr uint64_t prime3{ 0x165667B19E3779F9ull };
+	constexpr uint64_t prime4{ 0x85EBCA77C2B2AE63ull };
+	constexpr uint64_t prime5{ 0x27D4EB2F165667C5ull };
+
+	auto read64{ [](const unsigned char* p) { uint64_t v; std::memcpy(&v, p, 8); return v; } };
+	auto read32{ [](const unsigned char* p) { uint32_t v; std::memcpy(&v, p, 4); return v; } };
+	auto round{ [](uint64_t acc, uint64_t input) { return std::rotl(acc + input * prime2, 31) * prime1; } };
+	auto merge{ [&](uint64_t acc, uint64_t lane) { return (acc ^ round(0, lane)) * prime1 + prime4; } };
+
+	const unsigned char* p{ static_cast<const unsigned char*>(data) };
+	const unsigned char* end{ p + size };
+	uint64_t h;
+
+	if (size >= 32) {
+		// four independent lanes, so the cpu can have all four multiplies going at once
+		uint64_t v1{ seed + prime1 + prime2 };
+		uint64_t v2{ seed + prime2 };
+		uint64_t v3{ seed };
+		uint64_t v4{ seed - prime1 };
+		for (; end - p >= 32; p += 32) {
+			v1 = round(v1, read64(p));
+			v2 = round(v2, read64(p + 8));
+			v3 = round(v3, read64(p + 16));
+			v4 = round(v4, read64(p + 24));
+		}
+		h = std::rotl(v1, 1) + std::rotl(v2, 7) + std::rotl(v3, 12) + std::rotl(v4, 18);
+		h = merge(h, v1);
+		h = merge(h, v2);
+		h = merge(h, v3);
+		h = merge(h, v4);
+	}
+	else {
+		h = seed + prime5;
+	}
+
+	h += size;
+
+	for (; end - p >= 8; p += 8) {
+		h = std::rotl(h ^ round(0, read64(p)), 27) * prime1 + prime4;
+	}
+	if (end - p >= 4) {
+		h = std::rotl(h ^ (read32(p) * prime1), 23) * prime2 + prime3;
+		p += 4;
+	}
+	for (; p < end; p++) {
+		h = std::rotl(h ^ (*p * prime5), 11) * prime1;
+	}
+
+	h ^= h >> 33;
+	h *= prime2;
+	h ^= h >> 29;
+	h *= prime3;
+	h ^= h >> 32;
+	return h;
+}
+
+namespace
+{
+	// how much of each end of a file gets hashed in the first round
+	constexpr size_t sampleSize{ 4096 };
+
+	struct Candidate
+	{
+		std::filesystem::path path;
+		uint64_t size{ 0 };
+		// identifies the file itself, so extra hard links to it can be dropped. 0 if we don't know (windows)
+		uint64_t device{ 0 };
+		uint64_t inode{ 0 };
+		uint64_t hash{ 0 };
+		// a " (n)" copy. the plain name gets picked over these whenever there's a choice
+		bool suffixed{ false };
+		// the first round hashed the whole thing already
+		bool fullyHashed{ false };
+		bool ok{ false };
+	};
+
+	// drops the failed ones and anything whose size and hash nobody else shares. leaves them sorted by size, hash
+	void keepMatches(std::vector<Candidate>& candidates)
+	{
+		std::erase_if(candidates, [](const Candidate& c) { return !c.ok; });
+		std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+			return std::tie(a.size, a.hash, a.path) < std::tie(b.size, b.hash, b.path);
+		});
+
+		std::vector<Candidate> kept;
+		for (size_t begin{ 0 }; begin < candidates.size();) {
+			size_t end{ begin + 1 };
+			while (end < candidates.size() && candidates[end].size == candidates[begin].size && candidates[end].hash == candidates[begin].hash) {
+				end++;
+			}
+			if (end - begin > 1) {
+				std::move(candidates.begin() + begin, candidates.begin() + end, std::back_inserter(kept));
+			}
+			begin = end;
+		}
+		candidates = std::move(kept);
+	}
+
+	void statFile(Candidate& candidate, uint64_t minSize)
+	{
+#ifdef _WIN32
+		std::error_code ec;
+		if (!std::filesystem::is_regular_file(std::filesystem::symlink_status(candidate.path, ec))) {
+			return;
+		}
+		candidate.size = std::filesystem::file_size(candidate.path, ec);
+		candidate.ok = !ec && candidate.size >= minSize;
+#else
+		struct stat st;
+		if (lstat(candidate.path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+			return;
+		}
+		candidate.size = static_cast<uint64_t>(st.st_size);
+		candidate.device = static_cast<uint64_t>(st.st_dev);
+		candidate.inode = static_cast<uint64_t>(st.st_ino);
+		candidate.ok = candidate.size >= minSize;
+#endif
+	}
+
+	// reads a buffer's worth at each offset and hashes it into hash. false if it couldn't get all of it
+	bool hashAt(const std::filesystem::path& path, std::span<char> buffer, std::initializer_list<uint64_t> offsets, uint64_t& hash)
+	{
+#ifdef _WIN32
+		std::ifstream f{ path, std::ios::binary };
+		for (uint64_t offset : offsets) {
+			f.seekg(static_cast<std::streamoff>(offset));
+			if (!f.read(buffer.data(), static_cast<std::streamsize>(buffer.size()))) {
+				return false;
+			}
+			hash = FileOpHelpers::hash64(buffer.data(), buffer.size(), hash);
+		}
+		return true;
+#else
+		FileOpHelpers::posix::FileDescriptor fd{ open(path.c_str(), O_RDONLY | O_CLOEXEC) };
+		if (fd.fd < 0) {
+			return false;
+		}
+		for (uint64_t offset : offsets) {
+			if (pread(fd.fd, buffer.data(), buffer.size(), static_cast<off_t>(offset)) != static_cast<ssize_t>(buffer.size())) {
+				return false;
+			}
+			hash = FileOpHelpers::hash64(buffer.data(), buffer.size(), hash);
+		}
+		return true;
+#endif
+	}
+
+	// round one. small files just get hashed in full, big ones only get their two ends read. two plain reads are a lot
+	// cheaper than mapping a big file for the sake of two pages
+	void hashSample(Candidate& candidate)
+	{
+		if (candidate.size <= 2 * sampleSize) {
+			std::error_code ec;
+			FileOperations::FileContents contents{ FileOperations::readFile(candidate.path, ec) };
+			candidate.ok = !ec && contents.size() == candidate.size;
+			candidate.hash = FileOpHelpers::hash64(contents.view().data(), contents.size());
+			candidate.fullyHashed = true;
+			return;
+		}
+
+		char buffer[sampleSize];
+		candidate.ok = hashAt(candidate.path, buffer, { 0, candidate.size - sampleSize }, candidate.hash);
+	}
+
+	// round two, for whatever round one couldn't tell apart
+	void hashFull(Candidate& candidate)
+	{
+		if (candidate.fullyHashed) {
+			return;
+		}
+
+		std::error_code ec;
+		FileOperations::FileContents contents{ FileOperations::readFile(candidate.path, ec) };
+		candidate.ok = !ec && contents.size() == candidate.size;
+		candidate.hash = FileOpHelpers::hash64(contents.view().data(), contents.size());
+	}
+
+	// "name (2).txt" is a copy. "name.txt" is the original
+	bool isSuffixed(const std::filesystem::path& path)
+	{
+		std::string name{ path.filename().string() };
+		return FileOpHelpers::unSuffix(name) != name;
+	}
+
+	// swaps the duplicate for a hard link without its name ever going missing: link to a temporary name next to it,
+	// then rename that over the top
+	std::error_code replaceWithLink(const std::filesystem::path& original, const std::filesystem::path& duplicate)
+	{
+		std::error_code ec;
+		for (int n{ 0 }; n < 100; n++) {
+			std::filesystem::path temporary{ duplicate };
+			temporary += std::format(".dedup{}", n);
+
+			std::filesystem::create_hard_link(original, temporary, ec);
+			if (ec == std::errc::file_exists) {
+				continue;
+			}
+			if (ec) {
+				return ec;
+			}
+
+			std::filesystem::rename(temporary, duplicate, ec);
+			if (ec) {
+				std::error_code ignored;
+				std::filesystem::remove(temporary, ignored);
+			}
+			return ec;
+		}
+		return ec;
+	}
+
+	void runAction(FileOperations::DuplicateGroup& group, FileOperations::DuplicateAction action)
+	{
+		group.errors.resize(group.duplicates.size());
+
+		std::error_code ec;
+		FileOperations::FileContents original{ FileOperations::readFile(group.original, ec) };
+		if (ec) {
+			std::fill(group.errors.begin(), group.errors.end(), ec);
+			return;
+		}
+
+		for (size_t i{ 0 }; i < group.duplicates.size(); i++) {
+			const std::filesystem::path& duplicate{ group.duplicates[i] };
+
+			// the hashes matching only makes it almost certain
+			FileOperations::FileContents contents{ FileOperations::readFile(duplicate, group.errors[i]) };
+			if (group.errors[i]) {
+				continue;
+			}
+			if (contents.view() != original.view()) {
+				group.errors[i] = std::make_error_code(std::errc::operation_canceled);
+				continue;
+			}
+			contents = {};
+
+			if (action == FileOperations::DuplicateAction::Delete) {
+				std::filesystem::remove(duplicate, group.errors[i]);
+			}
+			else {
+				group.errors[i] = replaceWithLink(group.original, duplicate);
+			}
+		}
+	}
+
+	std::vector<FileOperations::DuplicateGroup> find(std::span<const std::filesystem::path> files, const FileOperations::DuplicateOptions& options)
+	{
+		FileOpHelpers::ThreadPool pool{ options.threadCount };
+
+		std::vector<Candidate> candidates(files.size());
+		FileOpHelpers::parallelFor(pool, files.size(), [&](size_t i) {
+			candidates[i].path = files[i];
+			candidates[i].suffixed = isSuffixed(files[i]);
+			statFile(candidates[i], options.minSize);
+		});
+		std::erase_if(candidates, [](const Candidate& c) { return !c.ok; });
+
+		// the same file listed twice, or under two hard links, isn't a duplicate of itself. only one name per file stays
+		std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+			return std::tie(a.device, a.inode, a.suffixed, a.path) < std::tie(b.device, b.inode, b.suffixed, b.path);
+		});
+		candidates.erase(std::unique(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+			return a.inode != 0 ? a.device == b.device && a.inode == b.inode : a.path == b.path;
+		}), candidates.end());
+
+		// every hash starts out as 0, so this is just by size
+		keepMatches(candidates);
+
+		FileOpHelpers::parallelFor(pool, candidates.size(), [&](size_t i) { hashSample(candidates[i]); });
+		keepMatches(candidates);
+
+		FileOpHelpers::parallelFor(pool, candidates.size(), [&](size_t i) { hashFull(candidates[i]); });
+		keepMatches(candidates);
+
+		std::vector<FileOperations::DuplicateGroup> groups;
+		for (size_t begin{ 0 }; begin < candidates.size();) {
+			size_t end{ begin + 1 };
+			while (end < candidates.size() && candidates[end].size == candidates[begin].size && candidates[end].hash == candidates[begin].hash) {
+				end++;
+			}
+
+			auto first{ candidates.begin() + begin };
+			auto last{ candidates.begin() + end };
+			std::stable_partition(first, last, [](const Candidate& c) { return !c.suffixed; });
+
+			FileOperations::DuplicateGroup& group{ groups.emplace_back() };
+			group.original = first->path;
+			group.size = first->size;
+			for (auto it{ first + 1 }; it != last; ++it) {
+				group.duplicates.push_back(std::move(it->path));
+			}
+
+			begin = end;
+		}
+
+		std::sort(groups.begin(), groups.end(), [](const auto& a, const auto& b) { return a.original < b.original; });
+
+		if (options.action != FileOperations::DuplicateAction::None) {
+			FileOpHelpers::parallelFor(pool, groups.size(), [&](size_t i) { runAction(groups[i], options.action); });
+		}
+
+		return groups;
+	}
+}
+
+std::vector<FileOperations::DuplicateGroup> FileOperations::findDuplicates(std::span<const std::filesystem::path> files, const DuplicateOptions& options)
+{
+	return find(files, options);
+}
+
+std::vector<FileOperations::DuplicateGroup> FileOperations::findDuplicates(std::span<const std::filesystem::path> files, const DuplicateOptions& options, std::error_code& ec) noexcept
+{
+	ec.clear();
+	try {
+		return find(files, options);
+	}
+	catch (...) {
+		// couldn't start the threads, or ran out of memory
+		ec = FileOpHelpers::currentExceptionError();
+		return {};
+	}
+}
+
+std::vector<FileOperations::DuplicateGroup> FileOperations::findDuplicates(const std::filesystem::path& folder, const DuplicateOptions& options)
+{
+	std::error_code ec;
+	std::vector<DuplicateGroup> groups{ findDuplicates(folder, options, ec) };
+	if (ec) {
+		throw std::filesystem::filesystem_error("cannot look for duplicates", folder, ec);
+	}
+	return groups;
+}
+
+std::vector<FileOperations::DuplicateGroup> FileOperations::findDuplicates(const std::filesystem::path& folder, const DuplicateOptions& options, std::error_code& ec) noexcept
+{
+	std::vector<std::filesystem::path> files;
+	try {
+		if (options.recursive) {
+			RecursiveOptions walk;
+			walk.threadCount = options.threadCount;
+			files = getAllFilesInFolderRecursive(folder, walk, ec);
+		}
+		else {
+			for (const auto& entry : getAllFilesInFolder(folder, ec)) {
+				files.push_back(entry.path());
+			}
+		}
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+	}
+	if (ec) {
+		return {};
+	}
+
+	return findDuplicates(files, options, ec);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <system_error>
+#include <vector>
+
+#include "FileOperations.h"
+
+namespace FileOpHelpers
+{
+	// xxh64. fast (the four lanes run in parallel, so it's mostly limited by how fast memory goes by) and the values are
+	// the same as every other xxh64 implementation, so they're fine to store and compare later. NOT a cryptographic hash
+	uint64_t hash64(const void* data, size_t size, uint64_t seed = 0);
+}
+
+namespace FileOperations
+{
+	enum class DuplicateAction
+	{
+		None,      // just report them
+		Delete,    // delete every duplicate, keep the original
+		Hardlink,  // replace every duplicate with a hard link to the original. same names, but the space is only used once
+	};
+
+	struct DuplicateOptions
+	{
+		DuplicateAction action{ DuplicateAction::None };
+		// files smaller than this are left alone. every empty file is a "duplicate" of every other one, which usually
+		// isn't what you're after
+		uint64_t minSize{ 1 };
+		// only for the folder version. walks into sub folders with getAllFilesInFolderRecursive() if true
+		bool recursive{ true };
+		// 0 means use every core
+		unsigned int threadCount{ 0 };
+	};
+
+	struct DuplicateGroup
+	{
+		// the one that gets kept. the plain "name.txt" of a copyFile() family beats its "name (n).txt" copies, otherwise
+		// it's whichever path sorts first
+		std::filesystem::path original;
+		std::vector<std::filesystem::path> duplicates;
+		uint64_t size;
+		// one per duplicate, for what happened when the action ran. all empty for DuplicateAction::None.
+		// errc::operation_canceled means it turned out not to be a real duplicate after all, and was left alone
+		std::vector<std::error_code> errors;
+	};
+
+	// finds files with the exact same contents. it narrows things down in rounds, so most files never get read at all:
+	// files are grouped by size, then files that share a size get the first and last 4KB hashed, and only the ones that
+	// still match after that get read in full. the reading and hashing is spread across a thread pool, and the files are
+	// memory mapped instead of read into buffers.
+	//
+	// before a duplicate gets deleted or hard linked, it's compared byte for byte with the original, so a hash
+	// collision can't cost you a file. files that can't be read, symlinks, and extra hard links to a file that's
+	// already in the list are skipped. groups come back sorted by original.
+	std::vector<DuplicateGroup> findDuplicates(std::span<const std::filesystem::path> files, const DuplicateOptions& options = {});
+	std::vector<DuplicateGroup> findDuplicates(std::span<const std::filesystem::path> files, const DuplicateOptions& options, std::error_code& ec) noexcept;
+	// every file in folder. throws if the folder can't be read
+	std::vector<DuplicateGroup> findDuplicates(const std::filesystem::path& folder, const DuplicateOptions& options = {});
+	std::vector<DuplicateGroup> findDuplicates(const std::filesystem::path& folder, const DuplicateOptions& options, std::error_code& ec) noexcept;
+}
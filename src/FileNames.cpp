@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+#include "FileOperations.h"
+
+namespace
+{
+	// one byte per char, one bit per rule set. checking a name is just a lookup per char instead of comparing every
+	// char against a list of bad ones
+	constexpr uint8_t illegalOnPosix{ 1 << 0 };
+	constexpr uint8_t illegalOnWindows{ 1 << 1 };
+	constexpr uint8_t notPortable{ 1 << 2 };
+	// the chars filenameHasIllegalChar() has always complained about
+	constexpr uint8_t classicIllegal{ 1 << 3 };
+
+	constexpr std::array<uint8_t, 256> makeCharRules()
+	{
+		std::array<uint8_t, 256> table{};
+
+		table['/'] |= illegalOnPosix;
+		table['\0'] |= illegalOnPosix;
+
+		for (unsigned char c : std::string_view{ "\\/:*?\"<>|" }) {
+			table[c] |= illegalOnWindows | classicIllegal;
+		}
+		for (int c{ 0 }; c < 32; c++) {
+			table[c] |= illegalOnWindows;
+		}
+
+		for (int c{ 0 }; c < 256; c++) {
+			bool portable{ (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '.' || c == '_' || c == '-' };
+			if (!portable) {
+				table[c] |= notPortable;
+			}
+		}
+
+		return table;
+	}
+
+	constexpr std::array<uint8_t, 256> charRules{ makeCharRules() };
+
+	constexpr uint8_t ruleMask(FileOpHelpers::NameRules rules)
+	{
+		switch (rules) {
+		case FileOpHelpers::NameRules::Posix:
+			return illegalOnPosix;
+		case FileOpHelpers::NameRules::Windows:
+			return illegalOnWindows;
+		case FileOpHelpers::NameRules::Portable:
+			return notPortable;
+		}
+		return illegalOnWindows;
+	}
+
+	// or together the flags of every char. no branch per char, and valid names (the usual case) never need more than
+	// this one pass
+	uint8_t charFlags(std::string_view name)
+	{
+		uint8_t flags{ 0 };
+		for (unsigned char c : name) {
+			flags |= charRules[c];
+		}
+		return flags;
+	}
+
+	// windows only looks at the part before the first dot, and ignores spaces at the end of it, so "nul.txt" and
+	// "CON .log" are reserved too. returns how long the reserved word is, or 0 if it isn't one
+	size_t reservedNameLength(std::string_view name)
+	{
+		std::string_view base{ name.substr(0, name.find('.')) };
+		while (!base.empty() && base.back() == ' ') {
+			base.remove_suffix(1);
+		}
+		if (base.size() != 3 && base.size() != 4) {
+			return 0;
+		}
+
+		char upper[4];
+		for (size_t i{ 0 }; i < base.size(); i++) {
+			upper[i] = (base[i] >= 'a' && base[i] <= 'z') ? static_cast<char>(base[i] - 'a' + 'A') : base[i];
+		}
+		std::string_view word{ upper, base.size() };
+
+		if (word.size() == 3) {
+			return (word == "CON" || word == "PRN" || word == "AUX" || word == "NUL") ? 3 : 0;
+		}
+		return ((word.starts_with("COM") || word.starts_with("LPT")) && word[3] >= '1' && word[3] <= '9') ? 4 : 0;
+	}
+
+	bool isDotName(std::string_view name)
+	{
+		return name == "." || name == "..";
+	}
+}
+
+char FileOpHelpers::filenameHasIllegalChar(const std::string& name)
+{
+	if (!(charFlags(name) & classicIllegal)) {
+		// return 0 (which is '\0', which is falsy)
+		return 0;
+	}
+
+	for (char c : name) {
+		if (charRules[static_cast<unsigned char>(c)] & classicIllegal) {
+			return c;
+		}
+	}
+	return 0;
+}
+
+FileOpHelpers::NameProblem FileOpHelpers::checkFileName(std::string_view name, NameRules rules)
+{
+	if (name.empty()) {
+		return NameProblem::Empty;
+	}
+	if (isDotName(name)) {
+		return NameProblem::ReservedName;
+	}
+	if (charFlags(name) & ruleMask(rules)) {
+		return NameProblem::IllegalChar;
+	}
+
+	if (rules != NameRules::Posix) {
+		if (reservedNameLength(name)) {
+			return NameProblem::ReservedName;
+		}
+		if (name.back() == '.' || name.back() == ' ') {
+			return NameProblem::TrailingDotOrSpace;
+		}
+	}
+
+	return NameProblem::None;
+}
+
+size_t FileOpHelpers::checkFileNames(std::span<const std::string> names, std::span<NameProblem> results, NameRules rules)
+{
+	if (results.size() < names.size()) {
+		throw std::invalid_argument("checkFileNames() needs a result for every name");
+	}
+
+	size_t bad{ 0 };
+	for (size_t i{ 0 }; i < names.size(); i++) {
+		results[i] = checkFileName(names[i], rules);
+		bad += results[i] != NameProblem::None;
+	}
+	return bad;
+}
+
+bool FileOpHelpers::sanitizeFileName(std::string& name, NameRules rules, char replacement)
+{
+	if (name.empty()) {
+		name.assign(1, replacement);
+		return true;
+	}
+
+	bool changed{ false };
+
+	uint8_t mask{ ruleMask(rules) };
+	if (charFlags(name) & mask) {
+		for (char& c : name) {
+			if (charRules[static_cast<unsigned char>(c)] & mask) {
+				c = replacement;
+			}
+		}
+		changed = true;
+	}
+
+	if (isDotName(name)) {
+		std::fill(name.begin(), name.end(), replacement);
+		return true;
+	}
+
+	if (rules != NameRules::Posix) {
+		for (auto it{ name.rbegin() }; it != name.rend() && (*it == '.' || *it == ' '); ++it) {
+			*it = replacement;
+			changed = true;
+		}
+
+		if (size_t length{ reservedNameLength(name) }) {
+			name.insert(length, 1, replacement);
+			changed = true;
+		}
+	}
+
+	return changed;
+}
+
+size_t FileOpHelpers::sanitizeFileNames(std::span<std::string> names, NameRules rules, char replacement)
+{
+	size_t changed{ 0 };
+	for (std::string& name : names) {
+		changed += sanitizeFileName(name, rules, replacement);
+	}
+	return changed;
+}
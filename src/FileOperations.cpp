@@ -1,27 +1,87 @@
 #include <fstream>
-#include <iostream>
+#include <cerrno>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
 #include <format>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
 
+#ifdef _WIN32
 #include <Windows.h>
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+#ifdef __linux__
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#endif
 
 #include "FileOperations.h"
+#include "PosixIO.h"
+#include "Simd.h"
+#include "Stats.h"
+#include "ThreadPool.h"
+
+using FileOpHelpers::stats::ScopedOp;
+using FileOperations::Stats::Op;
+
+#ifndef _WIN32
+using namespace FileOpHelpers::posix;
+#endif
 
-char FileOpHelpers::filenameHasIllegalChar(const std::string& name)
+namespace
 {
-	static const std::vector<char> illegalChars{'\\', '/', ':', '*', '?', '\"' , '<' , '>' , '|' };
+	// the overloads without an error_code are just the ones with one, plus this
+	void throwIfFailed(const std::error_code& ec, const char* what, const std::filesystem::path& path)
+	{
+		if (ec) {
+			throw std::filesystem::filesystem_error(what, path, ec);
+		}
+	}
 
-	for (char c : name) {
-		for (char illegalChar : illegalChars) {
-			if (c == illegalChar) {
-				return c;
-			}
+	void throwIfFailed(const std::error_code& ec, const char* what, const std::filesystem::path& from, const std::filesystem::path& to)
+	{
+		if (ec) {
+			throw std::filesystem::filesystem_error(what, from, to, ec);
 		}
 	}
 
-	// return 0 (which is '\0', which is falsy)
-	return 0;
+	// "folder/name (n).ext", or the plain basic path for n == 1
+	std::filesystem::path suffixedPath(const std::filesystem::path& basicPath, unsigned int n)
+	{
+		if (n == 1) {
+			return basicPath;
+		}
+
+		std::filesystem::path newPath{ basicPath };
+		newPath.replace_filename(std::format("{} ({}){}", basicPath.stem().string(), n, basicPath.extension().string()));
+		return newPath;
+	}
 }
 
+
 std::filesystem::path FileOpHelpers::renamePath(const std::filesystem::path& path, const std::string& newName)
 {
 	// making this a function since you can't replace the stem (which is how i think about it), so you always have to
@@ -33,287 +93,2096 @@ std::filesystem::path FileOpHelpers::renamePath(const std::filesystem::path& pat
 	return newPath;
 }
 
-bool FileOpHelpers::createFolder(const std::filesystem::path& path, bool fileHasNoExtension)
+namespace
 {
-	// returns whether a folder was created
+	// folders the write functions already know exist. split into shards, each with its own lock, so threads writing
+	// into different folders don't all line up behind one mutex
+	class FolderCache
+	{
+	public:
+		static constexpr size_t shardCount{ 16 };
+		static constexpr size_t shardCapacity{ 256 };
 
-	// create_directories() does nothing if they already exist, so we can freely call it without checking beforehand
+		bool contains(const std::string& folder)
+		{
+			Shard& shard{ shardFor(folder) };
+			std::lock_guard lock{ shard.mutex };
+			bool found{ shard.folders.contains(folder) };
+			(found ? m_hits : m_misses).fetch_add(1, std::memory_order_relaxed);
+			return found;
+		}
+
+		void insert(const std::string& folder)
+		{
+			Shard& shard{ shardFor(folder) };
+			std::lock_guard lock{ shard.mutex };
+			if (shard.folders.size() >= shardCapacity) {
+				// full. just kick out whatever's first, worst case that folder gets a create_directories() call again
+				shard.folders.erase(shard.folders.begin());
+			}
+			shard.folders.insert(folder);
+		}
 
-	// recognize if something is a file (has an extension or is marked as a file without an extension)
-	if (path.has_extension() || fileHasNoExtension) {
+		void forget(const std::string& folder)
+		{
+			// sub folders can live in any shard, so we have to look through all of them
+			for (Shard& shard : m_shards) {
+				std::lock_guard lock{ shard.mutex };
+				std::erase_if(shard.folders, [&folder](const std::string& cached) {
+					return cached.starts_with(folder)
+						&& (cached.size() == folder.size() || cached[folder.size()] == '/' || cached[folder.size()] == '\\');
+				});
+			}
+		}
 
-		// we have to check if it even has a parent path, since create_directories() cannot take in a blank path
-		if (path.has_parent_path()) {
-			// only create folders for the parent path (else it'll create a folder using the name of the file as well)
-			return std::filesystem::create_directories(path.parent_path());
+		void clear()
+		{
+			for (Shard& shard : m_shards) {
+				std::lock_guard lock{ shard.mutex };
+				shard.folders.clear();
+			}
 		}
-		else {
-			// else it's a file with no parent path, so there are no directories to create
-			return false;
+
+		FileOpHelpers::FolderCacheStats stats()
+		{
+			FileOpHelpers::FolderCacheStats stats{ m_hits.load(), m_misses.load(), 0 };
+			for (Shard& shard : m_shards) {
+				std::lock_guard lock{ shard.mutex };
+				stats.size += shard.folders.size();
+			}
+			return stats;
 		}
-	}
 
-	// else we treat it like a bunch of folders and create directories using the entire path
-	return std::filesystem::create_directories(path);
-}
+	private:
+		struct Shard
+		{
+			std::mutex mutex;
+			std::unordered_set<std::string> folders;
+		};
 
-std::string FileOpHelpers::unSuffix(const std::string& path)
-{
-	// c++ regex is seriously gross, so i'm just going to do this manually.
+		Shard& shardFor(const std::string& folder)
+		{
+			return m_shards[std::hash<std::string>{}(folder) % shardCount];
+		}
 
-	// if we have something like "../text files/file (2).txt", we want to return "../text files/file.txt", but there are
-	// a few things i want to take into account. i don't want to just find '(' and ')', delete them and what's in
-	// between, and call it a day. i want to make sure that it's the last thing in the filename, and that there are only
-	// digits between them, else we scrap it and return an unedited path
+		Shard m_shards[shardCount];
+		std::atomic<uint64_t> m_hits{ 0 };
+		std::atomic<uint64_t> m_misses{ 0 };
+	};
 
-	// find open and close parens
-	size_t endIdx{ path.find_last_of(')') };
-	size_t beginIdx{ path.find_last_of('(', endIdx) };
+	FolderCache& folderCache()
+	{
+		static FolderCache cache;
+		return cache;
+	}
 
-	if (beginIdx == std::string::npos || endIdx == std::string::npos) {
-		return path;
+	// "a/./b/" and "a/b" should be the same cache entry. absolute, so a relative folder stops matching once the working
+	// directory changes
+	std::string folderCacheKey(const std::filesystem::path& folder)
+	{
+		std::filesystem::path key{ folder };
+		if (key.is_relative()) {
+			std::error_code ec;
+			std::filesystem::path absolute{ std::filesystem::absolute(folder, ec) };
+			if (!ec) {
+				key = std::move(absolute);
+			}
+		}
+		key = key.lexically_normal();
+		if (!key.has_filename() && key.has_parent_path()) {
+			key = key.parent_path();
+		}
+		return key.string();
 	}
 
-	// make sure that there are only digits between the parens
-	for (size_t i{ beginIdx + 1 }; i < endIdx; ++i) {
-		char c{ path[i] };
-		if (!std::isdigit(c)) {
-			// we found something that's not a digit between the parens. return unedited path
-			return path;
+	// the folder createFolder() would make for path, or an empty path if there's nothing to make
+	std::filesystem::path folderToCreate(const std::filesystem::path& path, bool fileHasNoExtension)
+	{
+		// recognize if something is a file (has an extension or is marked as a file without an extension)
+		if (path.has_extension() || fileHasNoExtension) {
+			// only create folders for the parent path (else it'll create a folder using the name of the file as well).
+			// a file with no parent path has no folders to create
+			return path.parent_path();
 		}
+		// else we treat it like a bunch of folders and create directories using the entire path
+		return path;
 	}
 
-	// make sure "(n+)" is the last thing in the name. whitespace is allowed, any other char is not.
-	for (size_t i{ endIdx + 1 }; i < path.length(); ++i) {
-		char c{ path[i] };
-		
-		if (c == '.') {
-			// assume we've hit file extension part of name and quit
-			break;
+	// createFolder() for the write functions. create_directories() stats every part of the path, even when it all
+	// exists already, so folders we've already seen get skipped. that's only safe because every caller notices a
+	// folder that went missing since (retryAfterMissingFolder()) and makes it again, so nothing else goes through here
+	void createFileFolder(const std::filesystem::path& path, std::error_code& ec) noexcept
+	{
+		ec.clear();
+		try {
+			std::filesystem::path folder{ folderToCreate(path, false) };
+			if (folder.empty()) {
+				return;
+			}
+
+			std::string key{ folderCacheKey(folder) };
+			if (folderCache().contains(key)) {
+				return;
+			}
+
+			std::filesystem::create_directories(folder, ec);
+			if (!ec) {
+				folderCache().insert(key);
+			}
+		}
+		catch (...) {
+			ec = FileOpHelpers::currentExceptionError();
 		}
+	}
+}
+
+bool FileOpHelpers::createFolder(const std::filesystem::path& path, bool fileHasNoExtension)
+{
+	std::error_code ec;
+	bool created{ createFolder(path, fileHasNoExtension, ec) };
+	throwIfFailed(ec, "cannot create folder", path);
+	return created;
+}
+
+bool FileOpHelpers::createFolder(const std::filesystem::path& path, bool fileHasNoExtension, std::error_code& ec) noexcept
+{
+	try {
+		// returns whether a folder was created
+		ec.clear();
 
-		if (!std::isspace(c)) {
-			// we found something that's not whitespace after the closing parenthesis. return unedited path
-			return path;
+		// create_directories() does nothing if they already exist, so we can freely call it without checking
+		// beforehand. this always asks the file system, since the answer has to be right even if the folder was removed
+		// a moment ago. (only the write functions use the folder cache.)
+		std::filesystem::path folder{ folderToCreate(path, fileHasNoExtension) };
+
+		// create_directories() cannot take in a blank path
+		if (folder.empty()) {
+			return false;
 		}
+
+		return std::filesystem::create_directories(folder, ec);
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
 	}
+	return false;
+}
 
-	// gobble up whitespace before '('
-	beginIdx = path.find_last_not_of(' ', beginIdx - 1);
-	// gobble up whitespace after ')'
-	endIdx = path.find_first_not_of(' ', endIdx + 1);
-	
-	// if there was only whitespace at the end of a filename (file had no extension), endIdx will now be npos, so
-	// correct it
-	if (endIdx == std::string::npos) endIdx = path.length();
-
-	// both indices will point to the first non-space char, so go back one
-	beginIdx += 1;
-	endIdx -= 1;
-
-	std::string pathCopy{ path };
-	pathCopy.erase(
-		pathCopy.begin() + beginIdx,
-		pathCopy.begin() + endIdx + 1 // erase is [begin, end), so add one to end to include erasing endIdx
-	);
+void FileOpHelpers::forgetFolder(const std::filesystem::path& folder)
+{
+	folderCache().forget(folderCacheKey(folder));
+}
+
+void FileOpHelpers::clearFolderCache()
+{
+	folderCache().clear();
+}
 
-	// don't return a blank filename
-	if (pathCopy.empty()) {
+FileOpHelpers::FolderCacheStats FileOpHelpers::folderCacheStats()
+{
+	return folderCache().stats();
+}
+
+std::string FileOpHelpers::unSuffix(const std::string& path)
+{
+	// splitSuffix() does the actual work, so the rules live in one place and can be checked at compile time
+	SuffixSplit split{ splitSuffix(path) };
+	if (!split.found) {
 		return path;
 	}
 
-	return pathCopy;
+	std::string unSuffixed;
+	unSuffixed.reserve(split.head.size() + split.tail.size());
+	unSuffixed.append(split.head);
+	unSuffixed.append(split.tail);
+	return unSuffixed;
 }
 
 std::filesystem::path FileOpHelpers::getFirstUnusedFileName(const std::filesystem::path& path)
 {
-	// appends " (n)" to the end of a filename to make it unique
+	std::error_code ec;
+	std::filesystem::path unusedPath{ getFirstUnusedFileName(path, ec) };
+	throwIfFailed(ec, "cannot find an unused file name", path);
+	return unusedPath;
+}
+
+std::filesystem::path FileOpHelpers::getFirstUnusedFileName(const std::filesystem::path& path, std::error_code& ec) noexcept
+{
+	try {
+		// appends " (n)" to the end of a filename to make it unique
+
+		// first we should delete the suffix if it already has one. because if our path is "text (2).txt", we'll
+		// probably want to recognize it as "text.txt", so that this function properly generates "text (3).txt". if you
+		// don't do this, you'll get "text (2) (2).txt" instead
+#ifndef _WIN32
+		// every candidate gets written into the same stack buffer and stat'd straight from there, so trying a few
+		// hundred names doesn't allocate anything. only the one we hand back becomes a path
+		char basicBuffer[PATH_MAX];
+		char candidate[PATH_MAX + maxSuffixLength + 1];
+		std::string_view basic{ unSuffix(std::string_view{ path.native() }, basicBuffer) };
+		if (!basic.empty()) {
+			ec.clear();
+			for (unsigned int i{ 1 }; i < 1'000'000; i++) {
+				std::string_view testPath{ withSuffix(basic, i, candidate) };
+
+				struct stat st;
+				if (::stat(testPath.data(), &st) == 0) {
+					continue;
+				}
+				// same as what exists() counts as not being there
+				if (errno == ENOENT || errno == ENOTDIR) {
+					return std::filesystem::path{ testPath };
+				}
+				ec = posix::lastError();
+				return {};
+			}
+
+			ec = std::make_error_code(std::errc::file_exists);
+			return {};
+		}
+		// too long for the buffers. let the path version sort it out (and most likely fail with ENAMETOOLONG)
+#endif
 
-	// first we should delete the suffix if it already has one. because if our path is "text (2).txt", we'll probably
-	// want to recognize it as "text.txt", so that this function properly generates "text (3).txt". if you don't do
-	// this, you'll get "text (2) (2).txt" instead
-	std::filesystem::path basicPath{ FileOpHelpers::unSuffix(path.string()) };
+		std::filesystem::path basicPath{ FileOpHelpers::unSuffix(path.string()) };
 	
-	// test the basic path. if it's available, return it
-	if (!std::filesystem::exists(basicPath)) {
-		return basicPath;
+		// test the basic path, then start appending numbers until we find one that doesn't exist
+		for (unsigned int i{ 1 }; i < 1'000'000; i++) {
+			std::filesystem::path testPath{ suffixedPath(basicPath, i) };
+
+			bool taken{ std::filesystem::exists(testPath, ec) };
+			if (ec) {
+				return {};
+			}
+			if (!taken) {
+				return testPath;
+			}
+		}
+		// NOTE if you're doing this a lot in the same folder, use an UnusedNameIndex instead. for one-off calls this is
+		// still cheaper, since it usually only takes a stat or two, while the index has to read the whole folder.
+
+		// you have 1M files with the same name... why don't you do something about that?!
+		ec = std::make_error_code(std::errc::file_exists);
+		return {};
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+	}
+	return {};
+}
+
+namespace
+{
+	// creates path only if nothing is there yet. returns 0, or the errno it failed with
+	int createExclusive(const std::filesystem::path& path)
+	{
+#ifdef _WIN32
+		int fd{ _wopen(path.c_str(), _O_WRONLY | _O_CREAT | _O_EXCL, _S_IREAD | _S_IWRITE) };
+		if (fd < 0) {
+			return errno;
+		}
+		_close(fd);
+		return 0;
+#else
+		int fd{ open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666) };
+		if (fd < 0) {
+			return errno;
+		}
+		close(fd);
+		return 0;
+#endif
 	}
 
-	// else we have to start appending numbers and testing if they exist
-	for (unsigned int i{ 2 }; i < 1'000'000; i++) {
-		std::filesystem::path testPath{ basicPath };
-		std::string testName{ std::format("{} ({}){}", basicPath.stem().string(), i, basicPath.extension().string()) };
-		testPath.replace_filename(testName);
+	// which " (n)" number to try next, for every family that some thread is reserving a name in right now. entries
+	// go away as soon as nobody is using them, so a lone caller always starts from the bottom like
+	// getFirstUnusedFileName() does, and only threads that overlap share a counter
+	class ReservationTable
+	{
+	public:
+		static constexpr size_t shardCount{ 16 };
+
+		void enter(const std::string& family)
+		{
+			Shard& shard{ shardFor(family) };
+			std::lock_guard lock{ shard.mutex };
+			shard.families[family].users++;
+		}
+
+		unsigned int takeNumber(const std::string& family)
+		{
+			Shard& shard{ shardFor(family) };
+			std::lock_guard lock{ shard.mutex };
+			return shard.families[family].next++;
+		}
+
+		void leave(const std::string& family)
+		{
+			Shard& shard{ shardFor(family) };
+			std::lock_guard lock{ shard.mutex };
+			auto it{ shard.families.find(family) };
+			if (--it->second.users == 0) {
+				shard.families.erase(it);
+			}
+		}
+
+	private:
+		struct Family
+		{
+			unsigned int next{ 1 };
+			unsigned int users{ 0 };
+		};
+
+		struct Shard
+		{
+			std::mutex mutex;
+			std::unordered_map<std::string, Family> families;
+		};
+
+		Shard& shardFor(const std::string& family)
+		{
+			return m_shards[std::hash<std::string>{}(family) % shardCount];
+		}
+
+		Shard m_shards[shardCount];
+	};
+}
+
+std::filesystem::path FileOpHelpers::reserveUnusedFileName(const std::filesystem::path& path)
+{
+	std::error_code ec;
+	std::filesystem::path reserved{ reserveUnusedFileName(path, ec) };
+	throwIfFailed(ec, "cannot reserve file name", path);
+	return reserved;
+}
+
+std::filesystem::path FileOpHelpers::reserveUnusedFileName(const std::filesystem::path& path, std::error_code& ec) noexcept
+{
+	try {
+		static ReservationTable table;
+
+		ec.clear();
 
-		if (!std::filesystem::exists(testPath)) {
-			return testPath;
+		// same reason as getFirstUnusedFileName(). "text (2).txt" belongs to the "text.txt" family
+		std::filesystem::path basicPath{ FileOpHelpers::unSuffix(path.string()) };
+		std::string family{ basicPath.string() };
+
+		table.enter(family);
+		struct Leave
+		{
+			ReservationTable& table;
+			const std::string& family;
+			~Leave() { table.leave(family); }
+		} leave{ table, family };
+
+		while (true) {
+			unsigned int n{ table.takeNumber(family) };
+			if (n >= 1'000'000) {
+				ec = std::make_error_code(std::errc::file_exists);
+				return {};
+			}
+
+			std::filesystem::path candidate{ suffixedPath(basicPath, n) };
+
+			// the create is what actually makes it ours. the table just keeps our own threads from all trying the same
+			// one
+			int err{ createExclusive(candidate) };
+			if (err == 0) {
+				return candidate;
+			}
+			if (err != EEXIST) {
+				ec.assign(err, std::generic_category());
+				return {};
+			}
 		}
 	}
-	// OPT this can be made faster with a binary style search, but i never deal with that many files, so i'm not going
-	// to worry about it.
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+	}
+	return {};
+}
 
-	// TODO what do we do if all the file names are used?!
-	std::cerr << "ERROR: You have 1M files with the same name... why don't you do something about that?!\n";
-	return "pick a different file name";
+FileOpHelpers::UnusedNameIndex::UnusedNameIndex(const std::filesystem::path& folder)
+	: m_folder{ folder }
+{
+	rescan();
 }
 
-bool FileOperations::writeStringToFile(const std::string& string, const std::filesystem::path& path, std::ios_base::openmode mode)
+void FileOpHelpers::UnusedNameIndex::rescan()
 {
-	FileOpHelpers::createFolder(path);
+	clear();
 
-	std::ofstream f{ path, mode };
-	if (!f) {
-		return false;
+	// a folder that doesn't exist yet just means every name is free
+	std::error_code ec;
+	for (const auto& entry : std::filesystem::directory_iterator(m_folder, ec)) {
+		addFileName(entry.path().filename().string());
 	}
+}
 
-	f << string << '\n';
+void FileOpHelpers::UnusedNameIndex::clear()
+{
+	m_families.clear();
+}
 
-	f.flush();
-	f.close();
-	return true;
+unsigned int FileOpHelpers::UnusedNameIndex::familyNumber(const std::string& fileName, std::string& basicName)
+{
+	basicName = FileOpHelpers::unSuffix(fileName);
+
+	if (basicName == fileName) {
+		return 1;
+	}
+
+	// unSuffix() is forgiving about whitespace ("name   (3)  .txt"), but getFirstUnusedFileName() only ever tests for
+	// the exact "name (3).txt" spelling, so only count a number as taken if the file is spelled exactly like that.
+	// that way the index always agrees with the exists() version.
+	std::string_view digits{ splitSuffix(fileName).digits };
+
+	// we never generate "(0)", "(1)", or leading zeros, and anything this long is past our 1M limit anyway
+	if (digits.empty() || digits.size() > 7 || digits[0] == '0') {
+		return 0;
+	}
+
+	unsigned int n{ 0 };
+	for (char c : digits) {
+		n = n * 10 + static_cast<unsigned int>(c - '0');
+	}
+	if (n < 2) {
+		return 0;
+	}
+
+	// file names are at most 255 bytes, so anything that doesn't fit here isn't one of ours either
+	char spelled[512];
+	if (fileName != withSuffix(basicName, n, spelled)) {
+		return 0;
+	}
+
+	return n;
 }
 
-bool FileOperations::writeStringsToFile(const std::vector<std::string>& strings, const std::filesystem::path& path, std::ios_base::openmode mode)
+void FileOpHelpers::UnusedNameIndex::addFileName(const std::string& fileName)
 {
-	FileOpHelpers::createFolder(path);
+	std::string basicName;
+	if (unsigned int n{ familyNumber(fileName, basicName) }) {
+		m_families[basicName].used.insert(n);
+	}
+}
 
-	std::ofstream f{ path, mode };
-	if (!f) {
-		return false;
+void FileOpHelpers::UnusedNameIndex::removeFileName(const std::string& fileName)
+{
+	std::string basicName;
+	unsigned int n{ familyNumber(fileName, basicName) };
+	if (n == 0) {
+		return;
 	}
 
-	for (const std::string& s : strings) {
-		f << s << '\n';
+	auto it{ m_families.find(basicName) };
+	if (it == m_families.end()) {
+		return;
 	}
 
-	f.flush();
-	f.close();
-	return true;
+	Family& family{ it->second };
+	family.used.erase(n);
+	family.firstFree = std::min(family.firstFree, n);
+	if (family.used.empty()) {
+		m_families.erase(it);
+	}
 }
 
-std::vector<std::filesystem::directory_entry> FileOperations::getAllFilesInFolder(const std::filesystem::path& path, const std::string& fileType)
+std::filesystem::path FileOpHelpers::UnusedNameIndex::getFirstUnusedFileName(const std::filesystem::path& path)
 {
-	std::vector<std::filesystem::directory_entry> entries;
+	std::error_code ec;
+	std::filesystem::path unusedPath{ getFirstUnusedFileName(path, ec) };
+	throwIfFailed(ec, "cannot find an unused file name", path);
+	return unusedPath;
+}
 
-	for (auto& entry : std::filesystem::directory_iterator(path)) {
+std::filesystem::path FileOpHelpers::UnusedNameIndex::getFirstUnusedFileName(const std::filesystem::path& path, std::error_code& ec) noexcept
+{
+	try {
+		ec.clear();
 
-		// ignore folders
-		if (entry.is_directory()) {
-			continue;
+		// same reason as the regular version. strip any existing suffix first, so "text (2).txt" counts as "text.txt"
+		std::filesystem::path basicPath{ FileOpHelpers::unSuffix(path.string()) };
+
+		Family& family{ m_families[basicPath.filename().string()] };
+
+		while (family.used.contains(family.firstFree)) {
+			family.firstFree++;
 		}
-		// NOTE this plays nice with files without extensions. it properly recognizes that something is a file without
-		// an extension, and won't ignore it
 
-		// if we have a file type and it doesn't match this entry's extension. (compare() returns 0 if they match)
-		if (!fileType.empty() && fileType.compare(entry.path().extension().string()) != 0) {
-			continue;
+		unsigned int n{ family.firstFree };
+		if (n >= 1'000'000) {
+			ec = std::make_error_code(std::errc::file_exists);
+			return {};
 		}
-		// TODO do case-insensitive lowercase comparison?
 
-		entries.push_back(entry);
-	}
+		// hand it out and mark it as taken, so the next call gets the next one
+		family.used.insert(n);
 
-	return entries;
+		return suffixedPath(basicPath, n);
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+	}
+	return {};
 }
 
-void FileOperations::copyFile(const std::filesystem::path& path)
+std::filesystem::path FileOpHelpers::getFirstUnusedFileName(const std::filesystem::path& path, UnusedNameIndex& index)
 {
-	std::filesystem::path newPath{ FileOpHelpers::getFirstUnusedFileName(path.string()) };
+	return index.getFirstUnusedFileName(path);
+}
 
-	std::filesystem::copy(path, newPath);
+std::filesystem::path FileOpHelpers::getFirstUnusedFileName(const std::filesystem::path& path, UnusedNameIndex& index, std::error_code& ec) noexcept
+{
+	return index.getFirstUnusedFileName(path, ec);
 }
 
-bool FileOperations::renameFile(const std::filesystem::path& currentPath, const std::string& newName)
+namespace
 {
-	// check if the new name has illegal chars
-	char c{ FileOpHelpers::filenameHasIllegalChar(newName) };
-	if (c) {
-		std::cerr << "ERROR: FileOperations::renameFile() aborting! File contains illegal character: '" << c << "'\n";
-		return false;
+	// if opening a file failed because the folder cache was out of date (someone deleted the folder behind our back),
+	// fix the cache, make the folder again, and tell the caller to try one more time
+	bool retryAfterMissingFolder(const std::filesystem::path& path)
+	{
+		std::error_code ec;
+		if (!path.has_parent_path() || std::filesystem::exists(path.parent_path(), ec) || ec) {
+			return false;
+		}
+
+		FileOpHelpers::forgetFolder(path.parent_path());
+		std::filesystem::create_directories(path.parent_path(), ec);
+		return !ec;
 	}
-	
-	// construct new path
-	std::filesystem::path newPath{ FileOpHelpers::renamePath(currentPath, newName) };
 
-	// check if a file with that name already exists
-	if (std::filesystem::exists(newPath)) {
-		std::cerr << "ERROR: FileOperations::renameFile() aborting! File named " << newPath.filename() << " already exists!\n";
-		return false;
+	// streams don't say why they failed, but the open() underneath them leaves it in errno
+	std::error_code streamError()
+	{
+		return { errno ? errno : EIO, std::generic_category() };
 	}
-	// TODO i could easily generate a suffixed name here, but i'm not sure that's what i wantwant
+}
 
-	std::filesystem::rename(currentPath, newPath);
-	return true;
+bool FileOperations::writeStringToFile(const std::string& string, const std::filesystem::path& path, std::ios_base::openmode mode)
+{
+	std::error_code ec;
+	return writeStringToFile(string, path, mode, ec);
 }
 
-bool FileOperations::deleteFile(const std::filesystem::path& path)
+bool FileOperations::writeStringToFile(const std::string& string, const std::filesystem::path& path, std::ios_base::openmode mode, std::error_code& ec) noexcept
+{
+	ScopedOp op{ Op::WriteStringToFile, ec };
+	try {
+		createFileFolder(path, ec);
+		if (ec) {
+			return false;
+		}
+
+		errno = 0;
+		std::ofstream f{ path, mode };
+		if (!f && retryAfterMissingFolder(path)) {
+			f.open(path, mode);
+		}
+		if (!f) {
+			ec = streamError();
+			return false;
+		}
+
+		f << string << '\n';
+
+		f.flush();
+		if (!f) {
+			ec = streamError();
+			return false;
+		}
+		f.close();
+		op.addBytes(string.size() + 1);
+		return true;
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+	}
+	return false;
+}
+
+bool FileOperations::writeStringsToFile(const std::vector<std::string>& strings, const std::filesystem::path& path, std::ios_base::openmode mode)
 {
-	return std::filesystem::remove(path);
+	std::error_code ec;
+	return writeStringsToFile(strings, path, mode, ec);
 }
 
-bool FileOperations::sendToRecycleBin(const std::filesystem::path& path)
+bool FileOperations::writeStringsToFile(const std::vector<std::string>& strings, const std::filesystem::path& path, std::ios_base::openmode mode, std::error_code& ec) noexcept
 {
-	// i guess std::filesystem doesn't support this? so i have to use winapi
+	ScopedOp op{ Op::WriteStringsToFile, ec };
+	try {
+		if constexpr (FileOperations::Stats::enabled) {
+			for (const std::string& s : strings) {
+				op.addBytes(s.size() + 1);
+			}
+		}
 
-	// https://stackoverflow.com/questions/70257751/move-a-file-or-folder-to-the-recyclebin-trash-c17
-	
-	if (!std::filesystem::exists(path)) {
-		std::cerr << "ERROR: FileOperations::sendToRecycleBin() tried on a file that doesn't exist. Aborting.\n";
-		return false;
+		createFileFolder(path, ec);
+		if (ec) {
+			return false;
+		}
+
+#ifndef _WIN32
+		// posix has no text mode, so this writes the exact same bytes as the ofstream version, just without going
+		// through the stream machinery once per string
+		FileDescriptor fd{ openForWriting(path, mode) };
+		if (fd.fd < 0 && retryAfterMissingFolder(path)) {
+			fd.fd = openForWriting(path, mode);
+		}
+		if (fd.fd < 0 || !writeLines(fd.fd, strings)) {
+			ec = lastError();
+			return false;
+		}
+
+		return true;
+#else
+		errno = 0;
+		std::ofstream f{ path, mode };
+		if (!f && retryAfterMissingFolder(path)) {
+			f.open(path, mode);
+		}
+		if (!f) {
+			ec = streamError();
+			return false;
+		}
+
+		for (const std::string& s : strings) {
+			f << s << '\n';
+		}
+
+		f.flush();
+		if (!f) {
+			ec = streamError();
+			return false;
+		}
+		f.close();
+		return true;
+#endif
 	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+	}
+	return false;
+}
 
-	// std::filesystem doesn't require canonical paths. it works find with relative paths. 
-	//
-	// BUT windows is different, so always make sure it's a canonical path. that way we can support relative paths as
-	// well as using '/' (when windows actually requires '\\'). canonical() will convert for us
-	std::string pathStr{ std::filesystem::canonical(path).string() };
+namespace
+{
+	// O_DIRECT wants the buffer, the file offset, and the length all lined up to the device's block size. 4KB covers
+	// every block size you'll run into
+	constexpr size_t directAlignment{ 4096 };
 
-	// it requires strings to be double null terminated
-	pathStr += '\0';
+	struct FreeDeleter
+	{
+		void operator()(char* p) const { std::free(p); }
+	};
+}
 
-	// https://learn.microsoft.com/en-us/windows/win32/api/shellapi/ns-shellapi-shfileopstructa
-	SHFILEOPSTRUCTA fileOp;
-	fileOp.hwnd = NULL;
-	fileOp.wFunc = FO_DELETE;
-	fileOp.pFrom = pathStr.data();
-	fileOp.pTo = NULL;
-	fileOp.fFlags = FOF_ALLOWUNDO | FOF_NOCONFIRMATION;
-	
-	// https://learn.microsoft.com/en-us/windows/win32/api/shellapi/nf-shellapi-shfileoperationa
-	int result{ SHFileOperationA(&fileOp) };
-	
-	if (result != 0) {
-		std::cerr << "ERROR: FileOperations::sendToTrash() returned error code: " << result << '\n';
-		return false;
+#ifdef _WIN32
+// windows never makes one
+class FileOpHelpers::LargeWriter
+{
+};
+#else
+// two chunk buffers. the caller fills one while the io thread writes out the other one, so formatting (or copying) and
+// writing overlap, and only one chunk is ever in flight
+class FileOpHelpers::LargeWriter
+{
+public:
+	// fd stays the caller's, and has to outlive this. ec gets set if the buffers or the thread can't be had
+	LargeWriter(int fd, const FileOperations::LargeWriteOptions& options, std::error_code& ec) noexcept;
+	~LargeWriter();
+
+	LargeWriter(const LargeWriter&) = delete;
+	LargeWriter& operator=(const LargeWriter&) = delete;
+
+	bool write(const char* data, size_t size, std::error_code& ec) noexcept;
+	// writes out the partly filled chunk at the end, waits for everything, and gives back the preallocated space that
+	// didn't get used
+	bool finish(std::error_code& ec) noexcept;
+
+private:
+	// hands the chunk we've been filling to the io thread and switches to the other one
+	bool submit(std::error_code& ec) noexcept;
+	// waits for the io thread to be done with its chunk. false if writing it failed
+	bool wait(std::error_code& ec) noexcept;
+	void ioLoop();
+	void dropBehind(uint64_t offset, size_t size);
+
+	int m_fd;
+	bool m_direct{ false };
+	// also on when direct was asked for, so whatever can't go out with O_DIRECT still doesn't stay cached
+	bool m_dropCache;
+	bool m_preallocated{ false };
+	size_t m_chunkSize;
+	std::unique_ptr<char, FreeDeleter> m_chunks[2];
+	int m_filling{ 0 };
+	size_t m_filled{ 0 };
+	// where the chunk that's filling up goes in the file
+	uint64_t m_offset{ 0 };
+
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_done;
+	const char* m_pending{ nullptr };
+	size_t m_pendingSize{ 0 };
+	uint64_t m_pendingOffset{ 0 };
+	int m_error{ 0 };
+	bool m_stopping{ false };
+	std::thread m_io;
+};
+
+FileOpHelpers::LargeWriter::LargeWriter(int fd, const FileOperations::LargeWriteOptions& options, std::error_code& ec) noexcept
+	: m_fd{ fd }, m_dropCache{ options.dropCache || options.direct },
+	m_chunkSize{ std::max((options.chunkSize + directAlignment - 1) / directAlignment, size_t{ 1 }) * directAlignment }
+{
+	ec.clear();
+
+	int flags{ fcntl(fd, F_GETFL) };
+	off_t start{ lseek(fd, 0, (flags & O_APPEND) ? SEEK_END : SEEK_CUR) };
+	m_offset = start < 0 ? 0 : static_cast<uint64_t>(start);
+
+#ifdef __linux__
+	if (options.expectedSize > 0) {
+		// KEEP_SIZE, so the file doesn't claim to be bigger than what's actually been written yet. it's only a hint, so
+		// file systems that can't do it just don't get one
+		m_preallocated = fallocate(fd, FALLOC_FL_KEEP_SIZE, static_cast<off_t>(m_offset), static_cast<off_t>(options.expectedSize)) == 0;
 	}
-	// TODO figure out how to get descriptive error messages
+	// F_SETFL fails with EINVAL on file systems that don't do O_DIRECT
+	if (options.direct && flags >= 0 && m_offset % directAlignment == 0) {
+		m_direct = fcntl(fd, F_SETFL, flags | O_DIRECT) == 0;
+	}
+#elif defined(__APPLE__)
+	// the closest thing apple has to either one
+	if (options.direct || options.dropCache) {
+		fcntl(fd, F_NOCACHE, 1);
+	}
+#endif
 
-	return true;
+	for (auto& chunk : m_chunks) {
+		chunk.reset(static_cast<char*>(std::aligned_alloc(directAlignment, m_chunkSize)));
+		if (!chunk) {
+			ec = std::make_error_code(std::errc::not_enough_memory);
+			return;
+		}
+	}
+
+	try {
+		m_io = std::thread{ &LargeWriter::ioLoop, this };
+	}
+	catch (const std::system_error& e) {
+		ec = e.code();
+	}
 }
 
-bool FileOperations::openInExplorer(const std::filesystem::path& path)
+FileOpHelpers::LargeWriter::~LargeWriter()
 {
-	// https://stackoverflow.com/questions/354902/open-in-explorer
-	
-	if (!std::filesystem::exists(path)) {
-		std::cerr << "ERROR: FileOperations::openInExplorer() tried opening a file that doesn't exist. Aborting.\n";
-		return false;
+	{
+		std::lock_guard lock{ m_mutex };
+		m_stopping = true;
+	}
+	m_wake.notify_one();
+	if (m_io.joinable()) {
+		m_io.join();
 	}
+}
 
-	// same thing here. always use canonical path, so that passing in relative paths and paths with '/' is supported.
-	std::string pathStr{ std::filesystem::canonical(path).string() };
-	
-	// https://learn.microsoft.com/en-us/windows/win32/api/shellapi/nf-shellapi-shellexecutea
-	HINSTANCE _result{ ShellExecuteA(NULL, "open", pathStr.data(), NULL, NULL, SW_SHOWDEFAULT) };
-	// uh... int ptr is not a ptr, but it's a long long. neat
-	INT_PTR result{ reinterpret_cast<INT_PTR>(_result) };
-	if (result <= 32) { // this function returns a value greater than 32 if it succeeds
-		std::cerr << "ERROR: FileOperations::openInExplorer() returned error code: " << result << '\n';
-		return false;
+void FileOpHelpers::LargeWriter::ioLoop()
+{
+	std::unique_lock lock{ m_mutex };
+	while (true) {
+		m_wake.wait(lock, [&] { return m_pending || m_stopping; });
+		if (!m_pending) {
+			return;
+		}
+
+		const char* data{ m_pending };
+		size_t size{ m_pendingSize };
+		uint64_t offset{ m_pendingOffset };
+		lock.unlock();
+
+		int error{ 0 };
+		if (writeAll(m_fd, data, size)) {
+			dropBehind(offset, size);
+		}
+		else {
+			error = errno;
+		}
+
+		lock.lock();
+		if (error) {
+			m_error = error;
+		}
+		m_pending = nullptr;
+		m_done.notify_all();
 	}
-	// TODO figure out how to get descriptive error messages
-	
-	//ERROR_FILE_NOT_FOUND  // this will take you to the header where they're all defined
+}
 
-	return true;
-}
\ No newline at end of file
+void FileOpHelpers::LargeWriter::dropBehind(uint64_t offset, size_t size)
+{
+#ifdef __linux__
+	if (m_direct || !m_dropCache) {
+		return;
+	}
+	// dirty pages can't be dropped, so they have to hit the disk first. it's the io thread doing the waiting, so the
+	// next chunk keeps filling up in the meantime
+	sync_file_range(m_fd, static_cast<off_t>(offset), static_cast<off_t>(size),
+		SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+	posix_fadvise(m_fd, static_cast<off_t>(offset), static_cast<off_t>(size), POSIX_FADV_DONTNEED);
+#else
+	(void)offset;
+	(void)size;
+#endif
+}
+
+bool FileOpHelpers::LargeWriter::wait(std::error_code& ec) noexcept
+{
+	std::unique_lock lock{ m_mutex };
+	m_done.wait(lock, [&] { return !m_pending; });
+	if (m_error) {
+		ec.assign(m_error, std::generic_category());
+		return false;
+	}
+	return true;
+}
+
+bool FileOpHelpers::LargeWriter::submit(std::error_code& ec) noexcept
+{
+	if (!wait(ec)) {
+		return false;
+	}
+
+	{
+		std::lock_guard lock{ m_mutex };
+		m_pending = m_chunks[m_filling].get();
+		m_pendingSize = m_filled;
+		m_pendingOffset = m_offset;
+	}
+	m_wake.notify_one();
+
+	m_offset += m_filled;
+	m_filling ^= 1;
+	m_filled = 0;
+	return true;
+}
+
+bool FileOpHelpers::LargeWriter::write(const char* data, size_t size, std::error_code& ec) noexcept
+{
+	while (size > 0) {
+		size_t n{ std::min(size, m_chunkSize - m_filled) };
+		std::memcpy(m_chunks[m_filling].get() + m_filled, data, n);
+		m_filled += n;
+		data += n;
+		size -= n;
+
+		if (m_filled == m_chunkSize && !submit(ec)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool FileOpHelpers::LargeWriter::finish(std::error_code& ec) noexcept
+{
+	if (!wait(ec)) {
+		return false;
+	}
+
+	if (m_filled > 0) {
+#ifdef __linux__
+		// the last chunk is hardly ever a whole number of blocks, and O_DIRECT won't write anything else. so that one
+		// goes out the regular way
+		if (m_direct && m_filled % directAlignment != 0) {
+			fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL) & ~O_DIRECT);
+			m_direct = false;
+		}
+#endif
+		if (!writeAll(m_fd, m_chunks[m_filling].get(), m_filled)) {
+			ec = lastError();
+			return false;
+		}
+		dropBehind(m_offset, m_filled);
+		m_offset += m_filled;
+		m_filled = 0;
+	}
+
+#ifdef __linux__
+	if (m_preallocated) {
+		// truncating to the size it already is frees whatever was reserved past the end
+		struct stat st;
+		if (fstat(m_fd, &st) == 0) {
+			ftruncate(m_fd, st.st_size);
+		}
+	}
+#endif
+	return true;
+}
+#endif
+
+FileOpHelpers::LineWriter::LineWriter(const std::filesystem::path& path, std::ios_base::openmode mode, std::error_code& ec) noexcept
+	: m_start{ std::chrono::steady_clock::now() }
+{
+	createFileFolder(path, ec);
+	if (ec) {
+		finish(false);
+		return;
+	}
+
+	try {
+		// a bit extra, so the line that crosses flushSize doesn't make it grow
+		m_buffer.reserve(flushSize + 4096);
+
+#ifndef _WIN32
+		m_fd = openForWriting(path, mode);
+		if (m_fd < 0 && retryAfterMissingFolder(path)) {
+			m_fd = openForWriting(path, mode);
+		}
+		if (m_fd < 0) {
+			ec = lastError();
+			finish(false);
+		}
+#else
+		errno = 0;
+		m_file.open(path, mode);
+		if (!m_file && retryAfterMissingFolder(path)) {
+			m_file.open(path, mode);
+		}
+		if (!m_file) {
+			ec = streamError();
+			finish(false);
+		}
+#endif
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+		finish(false);
+	}
+}
+
+FileOpHelpers::LineWriter::LineWriter(const std::filesystem::path& path, std::ios_base::openmode mode, const FileOperations::LargeWriteOptions& options, std::error_code& ec) noexcept
+	: LineWriter{ path, mode, ec }
+{
+#ifndef _WIN32
+	if (ec) {
+		return;
+	}
+
+	m_large.reset(new (std::nothrow) LargeWriter{ m_fd, options, ec });
+	if (!m_large && !ec) {
+		ec = std::make_error_code(std::errc::not_enough_memory);
+	}
+	if (ec) {
+		finish(false);
+	}
+#else
+	(void)options;
+#endif
+}
+
+FileOpHelpers::LineWriter::~LineWriter()
+{
+	finish(false);
+}
+
+bool FileOpHelpers::LineWriter::writeOut(std::string_view data, std::error_code& ec) noexcept
+{
+#ifndef _WIN32
+	if (m_large) {
+		if (!m_large->write(data.data(), data.size(), ec)) {
+			finish(false);
+			return false;
+		}
+	}
+	else if (!writeAll(m_fd, data.data(), data.size())) {
+		ec = lastError();
+		finish(false);
+		return false;
+	}
+#else
+	m_file.write(data.data(), static_cast<std::streamsize>(data.size()));
+	if (!m_file) {
+		ec = streamError();
+		finish(false);
+		return false;
+	}
+#endif
+
+	m_written += data.size();
+	return true;
+}
+
+bool FileOpHelpers::LineWriter::flush(std::error_code& ec) noexcept
+{
+	if (!writeOut(m_buffer, ec)) {
+		return false;
+	}
+	// clear() keeps the capacity, so the next batch of lines goes into the same memory
+	m_buffer.clear();
+	return true;
+}
+
+bool FileOpHelpers::LineWriter::close(std::error_code& ec) noexcept
+{
+	if (!flush(ec)) {
+		return false;
+	}
+
+#ifndef _WIN32
+	if (m_large) {
+		bool finished{ m_large->finish(ec) };
+		// its thread has to be gone before the fd is
+		m_large.reset();
+		if (!finished) {
+			finish(false);
+			return false;
+		}
+	}
+
+	// close() is where nfs reports a failed write
+	int fd{ std::exchange(m_fd, -1) };
+	if (::close(fd) != 0) {
+		ec = lastError();
+		finish(false);
+		return false;
+	}
+#else
+	m_file.flush();
+	if (!m_file) {
+		ec = streamError();
+		finish(false);
+		return false;
+	}
+	m_file.close();
+#endif
+
+	finish(true);
+	return true;
+}
+
+void FileOpHelpers::LineWriter::finish(bool ok) noexcept
+{
+	m_large.reset();
+#ifndef _WIN32
+	if (m_fd >= 0) {
+		::close(std::exchange(m_fd, -1));
+	}
+#else
+	if (m_file.is_open()) {
+		m_file.close();
+	}
+#endif
+
+	// only the first call counts. a failed flush() finishes it early, and the destructor always calls it again
+	if (m_start == std::chrono::steady_clock::time_point{}) {
+		return;
+	}
+	if constexpr (FileOperations::Stats::enabled) {
+		auto elapsed{ std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start) };
+		FileOpHelpers::stats::record(Op::WriteStringsToFile, static_cast<uint64_t>(elapsed.count()), m_written, ok);
+	}
+	m_start = {};
+}
+
+bool FileOperations::writeStringToFile(const std::string& string, const std::filesystem::path& path, const LargeWriteOptions& options, std::ios_base::openmode mode)
+{
+	std::error_code ec;
+	return writeStringToFile(string, path, options, mode, ec);
+}
+
+bool FileOperations::writeStringToFile(const std::string& string, const std::filesystem::path& path, const LargeWriteOptions& options, std::ios_base::openmode mode, std::error_code& ec) noexcept
+{
+#ifdef _WIN32
+	(void)options;
+	return writeStringToFile(string, path, mode, ec);
+#else
+	ScopedOp op{ Op::WriteStringToFile, ec };
+	op.addBytes(string.size() + 1);
+
+	try {
+		createFileFolder(path, ec);
+		if (ec) {
+			return false;
+		}
+
+		FileDescriptor fd{ openForWriting(path, mode) };
+		if (fd.fd < 0 && retryAfterMissingFolder(path)) {
+			fd.fd = openForWriting(path, mode);
+		}
+		if (fd.fd < 0) {
+			ec = lastError();
+			return false;
+		}
+
+		{
+			// in its own scope, so its thread is gone before fd gets closed
+			FileOpHelpers::LargeWriter writer{ fd.fd, options, ec };
+			if (ec || !writer.write(string.data(), string.size(), ec) || !writer.write("\n", 1, ec) || !writer.finish(ec)) {
+				return false;
+			}
+		}
+
+		if (::close(fd.release()) != 0) {
+			ec = lastError();
+			return false;
+		}
+		return true;
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+	}
+	return false;
+#endif
+}
+
+FileOperations::FileContents::~FileContents()
+{
+	release();
+}
+
+FileOperations::FileContents::FileContents(FileContents&& other) noexcept
+	: m_map{ std::exchange(other.m_map, nullptr) }, m_size{ std::exchange(other.m_size, 0) }, m_buffer{ std::move(other.m_buffer) }
+{
+}
+
+FileOperations::FileContents& FileOperations::FileContents::operator=(FileContents&& other) noexcept
+{
+	if (this != &other) {
+		release();
+		m_map = std::exchange(other.m_map, nullptr);
+		m_size = std::exchange(other.m_size, 0);
+		m_buffer = std::move(other.m_buffer);
+	}
+	return *this;
+}
+
+void FileOperations::FileContents::release()
+{
+	if (m_map) {
+#ifdef _WIN32
+		UnmapViewOfFile(m_map);
+#else
+		munmap(const_cast<char*>(m_map), m_size);
+#endif
+	}
+	m_map = nullptr;
+	m_size = 0;
+	m_buffer.clear();
+}
+
+FileOperations::FileContents FileOperations::readFile(const std::filesystem::path& path)
+{
+	std::error_code ec;
+	FileContents contents{ readFile(path, ec) };
+	throwIfFailed(ec, "cannot open file", path);
+	return contents;
+}
+
+FileOperations::FileContents FileOperations::readFile(const std::filesystem::path& path, std::error_code& ec) noexcept
+{
+	try {
+		ec.clear();
+		FileContents contents;
+
+#ifdef _WIN32
+		HANDLE file{ CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL) };
+		if (file != INVALID_HANDLE_VALUE) {
+			LARGE_INTEGER size;
+			if (GetFileType(file) == FILE_TYPE_DISK && GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+				HANDLE mapping{ CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL) };
+				if (mapping) {
+					// the view keeps the mapping alive on its own, so both handles can be closed right away
+					void* view{ MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) };
+					CloseHandle(mapping);
+					if (view) {
+						contents.m_map = static_cast<const char*>(view);
+						contents.m_size = static_cast<size_t>(size.QuadPart);
+					}
+				}
+			}
+			CloseHandle(file);
+			if (contents.m_map) {
+				return contents;
+			}
+		}
+#else
+		FileDescriptor fd{ open(path.c_str(), O_RDONLY | O_CLOEXEC) };
+		if (fd.fd < 0) {
+			ec = lastError();
+			return {};
+		}
+
+		struct stat st;
+		if (fstat(fd.fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+			void* map{ mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd.fd, 0) };
+			if (map != MAP_FAILED) {
+				// we're almost always going to read it front to back, so tell the kernel to read ahead aggressively
+				madvise(map, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+
+				contents.m_map = static_cast<const char*>(map);
+				contents.m_size = static_cast<size_t>(st.st_size);
+				return contents;
+			}
+		}
+#endif
+
+		// couldn't map it, so just read the whole thing
+		errno = 0;
+		std::ifstream f{ path, std::ios::binary };
+		if (!f) {
+			ec = streamError();
+			return {};
+		}
+		contents.m_buffer.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+		if (f.bad()) {
+			ec = streamError();
+			return {};
+		}
+
+		return contents;
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+	}
+	return {};
+}
+
+std::vector<std::string_view> FileOperations::readLines(const FileContents& contents, CarriageReturns carriageReturns)
+{
+	std::string_view text{ contents.view() };
+	std::vector<std::string_view> lines;
+
+	bool strip{ carriageReturns == CarriageReturns::Strip };
+	size_t used{ FileOpHelpers::splitLines(text.data(), text.size(), lines, strip) };
+
+	// last line didn't end with a newline. keep it anyway
+	if (used < text.size()) {
+		std::string_view rest{ text.substr(used) };
+		if (strip && rest.back() == '\r') {
+			rest.remove_suffix(1);
+		}
+		lines.push_back(rest);
+	}
+
+	return lines;
+}
+
+FileOperations::LineReader::LineReader(const std::filesystem::path& path, size_t bufferSize, CarriageReturns carriageReturns)
+	: m_file{ path, std::ios::binary }, m_buffer(bufferSize > 0 ? bufferSize : 1), m_stripCarriageReturns{ carriageReturns == CarriageReturns::Strip }
+{
+	if (!m_file) {
+		throw std::filesystem::filesystem_error("cannot open file", path, std::make_error_code(std::errc::no_such_file_or_directory));
+	}
+}
+
+bool FileOperations::LineReader::nextBatch(std::vector<std::string_view>& lines)
+{
+	lines.clear();
+
+	while (true) {
+		// slide the partial line down to the front, so there's room to read the rest of it
+		if (m_begin > 0) {
+			std::memmove(m_buffer.data(), m_buffer.data() + m_begin, m_end - m_begin);
+			m_end -= m_begin;
+			m_begin = 0;
+		}
+
+		if (m_eof) {
+			if (m_end == 0) {
+				return false;
+			}
+
+			// the file didn't end with a newline, so whatever's left is the last line
+			std::string_view rest{ m_buffer.data(), m_end };
+			if (m_stripCarriageReturns && rest.back() == '\r') {
+				rest.remove_suffix(1);
+			}
+			lines.push_back(rest);
+			m_begin = m_end;
+			return true;
+		}
+
+		// a single line filled up the whole buffer
+		if (m_end == m_buffer.size()) {
+			m_buffer.resize(m_buffer.size() * 2);
+		}
+
+		m_file.read(m_buffer.data() + m_end, static_cast<std::streamsize>(m_buffer.size() - m_end));
+		size_t n{ static_cast<size_t>(m_file.gcount()) };
+		if (n == 0) {
+			m_eof = true;
+			continue;
+		}
+
+		// only look at the new bytes for newlines. the leftover bytes are known not to have any
+		size_t searchFrom{ m_end };
+		m_end += n;
+		size_t used{ FileOpHelpers::splitLines(m_buffer.data() + searchFrom, m_end - searchFrom, lines, m_stripCarriageReturns) };
+
+		if (!lines.empty()) {
+			// the first line actually starts at the front of the buffer, where the leftover partial line was
+			std::string_view first{ m_buffer.data(), static_cast<size_t>(lines.front().data() + lines.front().size() - m_buffer.data()) };
+			// the '\r' of a "\r\n" can end up on the old side of the split, where the kernel couldn't see it. that's
+			// only when the '\n' was the very first new byte. otherwise the kernel already took it off. (an empty first
+			// line isn't enough to go on: a lone "\r" before the '\n' comes out empty too, and then the old side's
+			// '\r' is part of the line)
+			bool newlineFirst{ m_buffer[searchFrom] == '\n' };
+			if (m_stripCarriageReturns && newlineFirst && !first.empty() && first.back() == '\r') {
+				first.remove_suffix(1);
+			}
+			lines.front() = first;
+			m_begin = searchFrom + used;
+			return true;
+		}
+	}
+}
+
+FileOperations::FolderFileRange::Iterator::Iterator(std::filesystem::directory_iterator it, const std::string* fileType, std::error_code* ec)
+	: m_it{ std::move(it) }, m_fileType{ fileType }, m_ec{ ec }
+{
+	skipFiltered();
+}
+
+FileOperations::FolderFileRange::Iterator& FileOperations::FolderFileRange::Iterator::operator++()
+{
+	advance();
+	skipFiltered();
+	return *this;
+}
+
+void FileOperations::FolderFileRange::Iterator::advance()
+{
+	if (!m_ec) {
+		++m_it;
+		return;
+	}
+
+	m_it.increment(*m_ec);
+	if (*m_ec) {
+		m_it = {};
+	}
+}
+
+namespace
+{
+	bool hasFileType(const std::filesystem::path& path, const std::string& fileType)
+	{
+		// if we have a file type and it doesn't match this entry's extension. (compare() returns 0 if they match)
+		// TODO do case-insensitive lowercase comparison?
+		return fileType.empty() || fileType.compare(path.extension().string()) == 0;
+	}
+
+	// is_directory(ec) that's fine with a dangling symlink (or a file deleted since the folder was read). those just
+	// aren't folders, same as the throwing is_directory() says, instead of failing the whole listing
+	bool isFolder(const std::filesystem::directory_entry& entry, std::error_code& ec)
+	{
+		bool folder{ entry.is_directory(ec) };
+		if (ec == std::errc::no_such_file_or_directory) {
+			ec.clear();
+		}
+		return folder;
+	}
+}
+
+void FileOperations::FolderFileRange::Iterator::skipFiltered()
+{
+	for (; m_it != std::filesystem::directory_iterator{}; advance()) {
+		const std::filesystem::directory_entry& entry{ *m_it };
+
+		// ignore folders
+		bool folder{ m_ec ? isFolder(entry, *m_ec) : entry.is_directory() };
+		if (m_ec && *m_ec) {
+			m_it = {};
+			return;
+		}
+		if (folder) {
+			continue;
+		}
+		// NOTE this plays nice with files without extensions. it properly recognizes that something is a file without
+		// an extension, and won't ignore it
+
+		if (m_fileType && !hasFileType(entry.path(), *m_fileType)) {
+			continue;
+		}
+
+		return;
+	}
+}
+
+FileOperations::FolderFileRange::FolderFileRange(const std::filesystem::path& path, std::string fileType, std::error_code* ec)
+	: m_path{ path }, m_fileType{ std::move(fileType) }, m_ec{ ec }
+{
+}
+
+FileOperations::FolderFileRange::Iterator FileOperations::FolderFileRange::begin() const
+{
+	if (!m_ec) {
+		return Iterator{ std::filesystem::directory_iterator(m_path), &m_fileType };
+	}
+	// filesInFolder() already failed
+	if (*m_ec) {
+		return {};
+	}
+
+	std::filesystem::directory_iterator it{ m_path, *m_ec };
+	if (*m_ec) {
+		return {};
+	}
+	return Iterator{ std::move(it), &m_fileType, m_ec };
+}
+
+FileOperations::FolderFileRange FileOperations::filesInFolder(const std::filesystem::path& path, const std::string& fileType)
+{
+	return FolderFileRange{ path, fileType };
+}
+
+FileOperations::FolderFileRange FileOperations::filesInFolder(const std::filesystem::path& path, const std::string& fileType, std::error_code& ec) noexcept
+{
+	ec.clear();
+	try {
+		return FolderFileRange{ path, fileType, &ec };
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+		// an empty path and type don't allocate
+		return FolderFileRange{ {}, {}, &ec };
+	}
+}
+
+std::vector<std::filesystem::directory_entry> FileOperations::getAllFilesInFolder(const std::filesystem::path& path, const std::string& fileType)
+{
+	// setOk() is never reached if the walk throws, so start out failed
+	ScopedOp op{ Op::GetAllFilesInFolder };
+	op.setOk(false);
+
+	std::vector<std::filesystem::directory_entry> entries;
+
+	for (const auto& entry : filesInFolder(path, fileType)) {
+		entries.push_back(entry);
+	}
+
+	op.setOk(true);
+	return entries;
+}
+
+std::vector<std::filesystem::directory_entry> FileOperations::getAllFilesInFolder(const std::filesystem::path& path, const std::string& fileType, std::error_code& ec) noexcept
+{
+	ScopedOp op{ Op::GetAllFilesInFolder, ec };
+	try {
+		std::vector<std::filesystem::directory_entry> entries;
+
+		// same walk as FolderFileRange, just with the error_code versions of everything
+		std::filesystem::directory_iterator it{ path, ec };
+		for (; !ec && it != std::filesystem::directory_iterator{}; it.increment(ec)) {
+			bool folder{ isFolder(*it, ec) };
+			if (ec) {
+				break;
+			}
+			if (!folder && hasFileType(it->path(), fileType)) {
+				entries.push_back(*it);
+			}
+		}
+
+		if (ec) {
+			return {};
+		}
+		return entries;
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+	}
+	return {};
+}
+
+namespace
+{
+	// state shared by every task of one recursive walk
+	struct RecursiveWalk
+	{
+		RecursiveWalk(const FileOperations::RecursiveOptions& options,
+			const std::function<void(int worker, const std::filesystem::path&)>& onFile, FileOpHelpers::ThreadPool& pool)
+			: options{ options }, onFile{ onFile }, pool{ pool }
+		{
+		}
+
+		const FileOperations::RecursiveOptions& options;
+		const std::function<void(int worker, const std::filesystem::path&)>& onFile;
+		FileOpHelpers::ThreadPool& pool;
+
+		// only needed when following symlinks, since that's the only way to walk in circles
+		std::mutex visitedMutex;
+		std::set<std::pair<uint64_t, uint64_t>> visited;
+
+		bool firstVisit(uint64_t device, uint64_t inode)
+		{
+			std::lock_guard lock{ visitedMutex };
+			return visited.emplace(device, inode).second;
+		}
+
+		bool passesFilter(const std::string& fileName) const
+		{
+			if (options.fileType.empty()) {
+				return true;
+			}
+
+			// same rules as path::extension(). a leading '.' (like ".gitignore") doesn't start an extension
+			size_t dotIdx{ fileName.find_last_of('.') };
+			if (dotIdx == std::string::npos || dotIdx == 0) {
+				return false;
+			}
+			return options.fileType.compare(0, std::string::npos, fileName, dotIdx) == 0;
+		}
+
+		bool canGoDeeper(int depth) const
+		{
+			return options.maxDepth < 0 || depth < options.maxDepth;
+		}
+
+		void walkFolder(const std::filesystem::path& folder, int depth);
+	};
+
+#ifdef _WIN32
+	void RecursiveWalk::walkFolder(const std::filesystem::path& folder, int depth)
+	{
+		// windows hands back the file attributes with the directory listing, so directory_entry doesn't have to hit
+		// the disk again to answer is_directory()
+		std::error_code ec;
+		for (const auto& entry : std::filesystem::directory_iterator(folder, ec)) {
+			bool isLink{ entry.is_symlink(ec) };
+
+			if (isLink && !options.followSymlinks) {
+				if (passesFilter(entry.path().filename().string())) {
+					onFile(pool.currentWorker(), entry.path());
+				}
+				continue;
+			}
+
+			if (entry.is_directory(ec)) {
+				if (canGoDeeper(depth)) {
+					std::filesystem::path child{ entry.path() };
+					pool.submit([this, child, depth] { walkFolder(child, depth + 1); });
+				}
+				continue;
+			}
+
+			if (passesFilter(entry.path().filename().string())) {
+				onFile(pool.currentWorker(), entry.path());
+			}
+		}
+	}
+#else
+	void RecursiveWalk::walkFolder(const std::filesystem::path& folder, int depth)
+	{
+		std::unique_ptr<DIR, int(*)(DIR*)> dir{ opendir(folder.c_str()), closedir };
+		if (!dir) {
+			// probably not allowed in. skip it instead of killing the whole walk
+			return;
+		}
+		int dirFd{ dirfd(dir.get()) };
+
+		// every folder gets checked once it's open, not just the ones reached through a link. otherwise a link back up
+		// the tree gets walked through once before the folder it points at is recognized
+		if (options.followSymlinks) {
+			struct stat st;
+			if (fstat(dirFd, &st) == 0 && !firstVisit(st.st_dev, st.st_ino)) {
+				return;
+			}
+		}
+
+		while (dirent* ent{ readdir(dir.get()) }) {
+			const char* name{ ent->d_name };
+			if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+				continue;
+			}
+
+			bool isDir{ ent->d_type == DT_DIR };
+
+			// only stat when readdir() couldn't tell us (some file systems always say DT_UNKNOWN), or when we need to
+			// know what a symlink points at
+			if (ent->d_type == DT_UNKNOWN || (ent->d_type == DT_LNK && options.followSymlinks)) {
+				struct stat st;
+				int flags{ options.followSymlinks ? 0 : AT_SYMLINK_NOFOLLOW };
+				if (fstatat(dirFd, name, &st, flags) == 0) {
+					isDir = S_ISDIR(st.st_mode);
+				}
+				// else it's a dangling symlink, so just report it as a file
+			}
+
+			if (isDir) {
+				if (canGoDeeper(depth)) {
+					std::filesystem::path child{ folder / name };
+					pool.submit([this, child = std::move(child), depth] { walkFolder(child, depth + 1); });
+				}
+				continue;
+			}
+
+			if (passesFilter(name)) {
+				onFile(pool.currentWorker(), folder / name);
+			}
+		}
+	}
+#endif
+
+	void walkRecursive(const std::filesystem::path& path, const FileOperations::RecursiveOptions& options,
+		const std::function<void(int worker, const std::filesystem::path&)>& onFile, FileOpHelpers::ThreadPool& pool, std::error_code& ec)
+	{
+		// fail loudly on the top folder, same as getAllFilesInFolder() would
+		bool isFolder{ std::filesystem::is_directory(path, ec) };
+		if (ec) {
+			return;
+		}
+		if (!isFolder) {
+			ec = std::make_error_code(std::errc::not_a_directory);
+			return;
+		}
+
+		RecursiveWalk walk{ options, onFile, pool };
+		pool.submit([&walk, &path] { walk.walkFolder(path, 0); });
+		pool.wait();
+	}
+}
+
+std::vector<std::filesystem::path> FileOperations::getAllFilesInFolderRecursive(const std::filesystem::path& path, const RecursiveOptions& options)
+{
+	std::error_code ec;
+	std::vector<std::filesystem::path> files{ getAllFilesInFolderRecursive(path, options, ec) };
+	throwIfFailed(ec, "cannot walk folder", path);
+	return files;
+}
+
+std::vector<std::filesystem::path> FileOperations::getAllFilesInFolderRecursive(const std::filesystem::path& path, const RecursiveOptions& options, std::error_code& ec) noexcept
+{
+	ec.clear();
+
+	try {
+		// every worker collects into its own list, so they never fight over a lock. stitch them together at the end
+		std::vector<std::vector<std::filesystem::path>> perWorker;
+
+		FileOpHelpers::ThreadPool pool{ options.threadCount };
+		perWorker.resize(pool.threadCount());
+
+		walkRecursive(path, options,
+			[&perWorker](int worker, const std::filesystem::path& file) { perWorker[worker].push_back(file); },
+			pool, ec
+		);
+		if (ec) {
+			return {};
+		}
+
+		size_t total{ 0 };
+		for (const auto& files : perWorker) {
+			total += files.size();
+		}
+
+		std::vector<std::filesystem::path> files;
+		files.reserve(total);
+		for (auto& workerFiles : perWorker) {
+			std::move(workerFiles.begin(), workerFiles.end(), std::back_inserter(files));
+		}
+		return files;
+	}
+	catch (...) {
+		// couldn't start the threads, or ran out of memory
+		ec = FileOpHelpers::currentExceptionError();
+		return {};
+	}
+}
+
+void FileOperations::forEachFileRecursive(const std::filesystem::path& path, const std::function<void(const std::filesystem::path&)>& onFile, const RecursiveOptions& options)
+{
+	FileOpHelpers::ThreadPool pool{ options.threadCount };
+
+	std::error_code ec;
+	walkRecursive(path, options,
+		[&onFile](int, const std::filesystem::path& file) { onFile(file); },
+		pool, ec
+	);
+	throwIfFailed(ec, "cannot walk folder", path);
+}
+
+void FileOperations::forEachFileRecursive(const std::filesystem::path& path, const std::function<void(const std::filesystem::path&)>& onFile, const RecursiveOptions& options, std::error_code& ec) noexcept
+{
+	ec.clear();
+
+	try {
+		FileOpHelpers::ThreadPool pool{ options.threadCount };
+		walkRecursive(path, options,
+			[&onFile](int, const std::filesystem::path& file) { onFile(file); },
+			pool, ec
+		);
+	}
+	catch (...) {
+		// couldn't start the threads, or onFile threw
+		ec = FileOpHelpers::currentExceptionError();
+	}
+}
+
+#ifndef _WIN32
+namespace FileOpHelpers::posix
+{
+	bool copyFd(int in, int out, size_t size, FileOpHelpers::CopyStrategy& strategy)
+	{
+#ifdef __linux__
+		strategy = FileOpHelpers::CopyStrategy::Reflink;
+		if (ioctl(out, FICLONE, in) == 0) {
+			return true;
+		}
+
+		// these all mean "not here", as opposed to an actual I/O error
+		auto unsupported{ [](int err) {
+			return err == ENOSYS || err == EXDEV || err == EINVAL || err == EOPNOTSUPP || err == ENOTSUP || err == EBADF;
+		} };
+
+		// things like /proc files claim to be empty regular files, so only the read() loop can be trusted with them
+		size_t copied{ 0 };
+		strategy = FileOpHelpers::CopyStrategy::CopyFileRange;
+		while (copied < size) {
+			ssize_t n{ copy_file_range(in, nullptr, out, nullptr, size - copied, 0) };
+			if (n < 0) {
+				if (errno == EINTR) continue;
+				if (copied == 0 && unsupported(errno)) break;
+				return false;
+			}
+			if (n == 0) break; // file shrank underneath us
+			copied += static_cast<size_t>(n);
+		}
+		if (copied > 0) {
+			return true;
+		}
+
+		strategy = FileOpHelpers::CopyStrategy::Sendfile;
+		while (copied < size) {
+			ssize_t n{ sendfile(out, in, nullptr, size - copied) };
+			if (n < 0) {
+				if (errno == EINTR) continue;
+				if (copied == 0 && unsupported(errno)) break;
+				return false;
+			}
+			if (n == 0) break;
+			copied += static_cast<size_t>(n);
+		}
+		if (copied > 0) {
+			return true;
+		}
+#else
+		(void)size;
+#endif
+
+		strategy = FileOpHelpers::CopyStrategy::Buffered;
+		std::unique_ptr<char[]> buffer{ new char[128 * 1024] };
+		while (true) {
+			ssize_t n{ read(in, buffer.get(), 128 * 1024) };
+			if (n < 0) {
+				if (errno == EINTR) continue;
+				return false;
+			}
+			if (n == 0) {
+				return true;
+			}
+			if (!writeAll(out, buffer.get(), static_cast<size_t>(n))) {
+				return false;
+			}
+		}
+	}
+}
+#endif
+
+namespace
+{
+	// intoReserved means to is an empty file that reserveUnusedFileName() made for us, so it's fine to write over it.
+	// bytesCopied (if given) gets the size of a copied regular file, for the stats
+	FileOpHelpers::CopyStrategy copyContents(const std::filesystem::path& from, const std::filesystem::path& to, bool intoReserved, std::error_code& ec, uint64_t* bytesCopied = nullptr)
+	{
+		using FileOpHelpers::CopyStrategy;
+
+		ec.clear();
+
+#ifdef _WIN32
+		std::filesystem::copy(from, to, intoReserved ? std::filesystem::copy_options::overwrite_existing : std::filesystem::copy_options::none, ec);
+		return CopyStrategy::Filesystem;
+#else
+		FileDescriptor in{ open(from.c_str(), O_RDONLY | O_CLOEXEC) };
+		if (in.fd < 0) {
+			ec = lastError();
+			return {};
+		}
+
+		struct stat st;
+		if (fstat(in.fd, &st) != 0) {
+			ec = lastError();
+			return {};
+		}
+
+		// folders, fifos, devices etc. keep their std::filesystem::copy() behavior
+		if (!S_ISREG(st.st_mode)) {
+			if (intoReserved) {
+				// the placeholder file would just be in the way
+				std::filesystem::remove(to, ec);
+			}
+			if (!ec) {
+				std::filesystem::copy(from, to, ec);
+			}
+			return CopyStrategy::Filesystem;
+		}
+
+		// O_EXCL so we fail instead of clobbering something, same as std::filesystem::copy(). a reserved file is ours
+		// already, so that one just gets opened
+		int flags{ intoReserved ? O_WRONLY | O_TRUNC | O_CLOEXEC : O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC };
+		FileDescriptor out{ open(to.c_str(), flags, st.st_mode & 07777) };
+		if (out.fd < 0) {
+			ec = lastError();
+			return {};
+		}
+
+		CopyStrategy strategy;
+		if (!copyFd(in.fd, out.fd, static_cast<size_t>(st.st_size), strategy) || fchmod(out.fd, st.st_mode & 07777) != 0) {
+			ec = lastError();
+			// don't leave half a file lying around
+			unlink(to.c_str());
+			return {};
+		}
+
+		if (bytesCopied) {
+			*bytesCopied = static_cast<uint64_t>(st.st_size);
+		}
+		return strategy;
+#endif
+	}
+}
+
+FileOpHelpers::CopyStrategy FileOpHelpers::copyFileContents(const std::filesystem::path& from, const std::filesystem::path& to)
+{
+	std::error_code ec;
+	CopyStrategy strategy{ copyContents(from, to, false, ec) };
+	throwIfFailed(ec, "cannot copy file", from, to);
+	return strategy;
+}
+
+FileOpHelpers::CopyStrategy FileOpHelpers::copyFileContents(const std::filesystem::path& from, const std::filesystem::path& to, std::error_code& ec) noexcept
+{
+	try {
+		return copyContents(from, to, false, ec);
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+	}
+	return {};
+}
+
+FileOperations::CopyResult FileOperations::copyFile(const std::filesystem::path& path)
+{
+	std::error_code ec;
+	CopyResult result{ copyFile(path, ec) };
+	throwIfFailed(ec, "cannot copy file", path);
+	return result;
+}
+
+FileOperations::CopyResult FileOperations::copyFile(const std::filesystem::path& path, std::error_code& ec) noexcept
+{
+	ScopedOp op{ Op::CopyFile, ec };
+	try {
+		// a missing source's own name is free, so the reservation below would hand it out and we'd "copy" the empty
+		// placeholder onto itself
+		bool sourceExists{ std::filesystem::exists(path, ec) };
+		if (!sourceExists && !ec) {
+			ec = std::make_error_code(std::errc::no_such_file_or_directory);
+		}
+		if (ec) {
+			return {};
+		}
+
+		// reserve the name first, so threads (or processes) copying the same file at the same time can't pick the same
+		// one
+		std::filesystem::path newPath{ FileOpHelpers::reserveUnusedFileName(path, ec) };
+		if (ec) {
+			return {};
+		}
+
+		uint64_t bytes{ 0 };
+		FileOpHelpers::CopyStrategy strategy{ copyContents(path, newPath, true, ec, &bytes) };
+		op.addBytes(bytes);
+		if (ec) {
+			// give the name back
+			std::error_code ignored;
+			std::filesystem::remove(newPath, ignored);
+			return {};
+		}
+
+		return { newPath, strategy };
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+	}
+	return {};
+}
+
+FileOperations::CopyResult FileOperations::copyFile(const std::filesystem::path& path, FileOpHelpers::UnusedNameIndex& index)
+{
+	std::error_code ec;
+	CopyResult result{ copyFile(path, index, ec) };
+	throwIfFailed(ec, "cannot copy file", path);
+	return result;
+}
+
+FileOperations::CopyResult FileOperations::copyFile(const std::filesystem::path& path, FileOpHelpers::UnusedNameIndex& index, std::error_code& ec) noexcept
+{
+	ScopedOp op{ Op::CopyFile, ec };
+	try {
+		while (true) {
+			std::filesystem::path newPath{ index.getFirstUnusedFileName(path, ec) };
+			if (ec) {
+				return {};
+			}
+
+			uint64_t bytes{ 0 };
+			FileOpHelpers::CopyStrategy strategy{ copyContents(path, newPath, false, ec, &bytes) };
+			if (!ec) {
+				op.addBytes(bytes);
+				return { newPath, strategy };
+			}
+
+			// someone else made that file after the index read the folder. the index has it marked as taken now, so
+			// just go again with the next one
+			if (ec != std::errc::file_exists) {
+				return {};
+			}
+		}
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+	}
+	return {};
+}
+
+bool FileOperations::renameFile(const std::filesystem::path& currentPath, const std::string& newName)
+{
+	std::error_code ec;
+	if (renameFile(currentPath, newName, ec)) {
+		return true;
+	}
+
+	// a bad or taken name was always just a false. anything else is a real failure
+	if (ec != std::errc::invalid_argument && ec != std::errc::file_exists) {
+		throw std::filesystem::filesystem_error("cannot rename", currentPath, FileOpHelpers::renamePath(currentPath, newName), ec);
+	}
+	return false;
+}
+
+bool FileOperations::renameFile(const std::filesystem::path& currentPath, const std::string& newName, std::error_code& ec) noexcept
+{
+	ScopedOp op{ Op::RenameFile, ec };
+	try {
+		ec.clear();
+
+		// check if the new name has illegal chars
+		if (FileOpHelpers::filenameHasIllegalChar(newName)) {
+			ec = std::make_error_code(std::errc::invalid_argument);
+			return false;
+		}
+	
+		// construct new path
+		std::filesystem::path newPath{ FileOpHelpers::renamePath(currentPath, newName) };
+
+		// check if a file with that name already exists
+		bool taken{ std::filesystem::exists(newPath, ec) };
+		if (ec) {
+			return false;
+		}
+		if (taken) {
+			ec = std::make_error_code(std::errc::file_exists);
+			return false;
+		}
+		// TODO i could easily generate a suffixed name here, but i'm not sure that's what i wantwant
+
+		std::filesystem::rename(currentPath, newPath, ec);
+		return !ec;
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+	}
+	return false;
+}
+
+bool FileOperations::deleteFile(const std::filesystem::path& path)
+{
+	std::error_code ec;
+	bool removed{ deleteFile(path, ec) };
+	throwIfFailed(ec, "cannot remove", path);
+	return removed;
+}
+
+bool FileOperations::deleteFile(const std::filesystem::path& path, std::error_code& ec) noexcept
+{
+	ScopedOp op{ Op::DeleteFile, ec };
+	return std::filesystem::remove(path, ec);
+}
+
+bool FileOperations::openInExplorer(const std::filesystem::path& path)
+{
+	std::error_code ec;
+	return openInExplorer(path, ec);
+}
+
+bool FileOperations::openInExplorer(const std::filesystem::path& path, std::error_code& ec) noexcept
+{
+	try {
+#ifdef _WIN32
+		// https://stackoverflow.com/questions/354902/open-in-explorer
+	
+		// same thing here. always use canonical path, so that passing in relative paths and paths with '/' is
+		// supported.
+		std::string pathStr{ std::filesystem::canonical(path, ec).string() };
+		if (ec) {
+			return false;
+		}
+	
+		// https://learn.microsoft.com/en-us/windows/win32/api/shellapi/nf-shellapi-shellexecutea
+		HINSTANCE _result{ ShellExecuteA(NULL, "open", pathStr.data(), NULL, NULL, SW_SHOWDEFAULT) };
+		// uh... int ptr is not a ptr, but it's a long long. neat
+		INT_PTR result{ reinterpret_cast<INT_PTR>(_result) };
+		if (result <= 32) { // this function returns a value greater than 32 if it succeeds
+			// the small ones (file not found, path not found, access denied...) line up with the system error codes
+			ec.assign(static_cast<int>(result), std::system_category());
+			return false;
+		}
+	
+		//ERROR_FILE_NOT_FOUND  // this will take you to the header where they're all defined
+
+		return true;
+#else
+		// same check as canonical() does on windows
+		std::filesystem::path absolute{ std::filesystem::canonical(path, ec) };
+		if (ec) {
+			return false;
+		}
+
+		// hand it to the desktop's file manager. xdg-open is the freedesktop way, mac has open
+#ifdef __APPLE__
+		const char* opener{ "open" };
+#else
+		const char* opener{ "xdg-open" };
+#endif
+		std::string pathStr{ absolute.string() };
+		char* argv[]{ const_cast<char*>(opener), pathStr.data(), nullptr };
+
+		pid_t pid;
+		int err{ posix_spawnp(&pid, opener, nullptr, nullptr, argv, environ) };
+		if (err != 0) {
+			ec.assign(err, std::generic_category());
+			return false;
+		}
+
+		// xdg-open hands off to the file manager and exits right away, so waiting on it doesn't block for long (and
+		// doesn't leave a zombie behind)
+		int status;
+		while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			ec = std::make_error_code(std::errc::io_error);
+			return false;
+		}
+
+		return true;
+#endif
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+	}
+	return false;
+}
@@ -1,14 +1,72 @@
 #pragma once
 
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <new>
+#include <ranges>
+#include <span>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
 #include <vector>
 #include <filesystem>
+#include <fstream>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+
+// every function that can fail has a second overload taking a std::error_code& as its last argument, same as
+// std::filesystem. those ones never throw and never print anything. they set ec (and return false/an empty result)
+// instead, which is a lot cheaper when failing is a normal thing to happen, like a file vanishing before you get to
+// it. the overloads without ec work like they always have. they throw filesystem_error, except where they already
+// reported a failure by returning false.
+
+namespace FileOperations
+{
+	struct LargeWriteOptions;
+}
 
 namespace FileOpHelpers
 {
 	// returns illegal char if file name has one. 0 if it's good. (ONLY tests the file name, not any directory names)
 	char filenameHasIllegalChar(const std::string& name);
 
+	// which file system's idea of a legal file name to check against
+	enum class NameRules
+	{
+		Posix,     // anything but '/' and '\0'
+		Windows,   // no \ / : * ? " < > | or control chars, no reserved names (CON, NUL, COM1...), no trailing dots/spaces
+		Portable,  // windows rules, and only A-Z a-z 0-9 . _ - (the posix portable file name set), so it's safe anywhere
+	};
+
+	enum class NameProblem : uint8_t
+	{
+		None,
+		Empty,
+		IllegalChar,
+		ReservedName,        // "CON", "nul.txt", or "." and ".."
+		TrailingDotOrSpace,  // windows quietly strips these, so "file." and "file" end up being the same file
+	};
+
+	// checks one name (not a path) against rules
+	NameProblem checkFileName(std::string_view name, NameRules rules = NameRules::Windows);
+
+	// checks a whole batch of names at once, which is what you want for things like imports. results[i] gets the
+	// problem with names[i], so it has to be at least as big as names. returns how many names have a problem.
+	size_t checkFileNames(std::span<const std::string> names, std::span<NameProblem> results, NameRules rules = NameRules::Windows);
+
+	// rewrites name in place so it passes checkFileName(). illegal chars and trailing dots/spaces become replacement,
+	// reserved names get replacement stuck on the end ("CON.txt" -> "CON_.txt"), and an empty name becomes just
+	// replacement. (so replacement had better be legal itself.) returns whether anything changed.
+	bool sanitizeFileName(std::string& name, NameRules rules = NameRules::Windows, char replacement = '_');
+
+	// same thing for a whole batch. returns how many names it changed
+	size_t sanitizeFileNames(std::span<std::string> names, NameRules rules = NameRules::Windows, char replacement = '_');
+
 	// make a new path with the new name
 	std::filesystem::path renamePath(const std::filesystem::path& path, const std::string& newName);
 
@@ -17,13 +75,342 @@ namespace FileOpHelpers
 	// 2. folders/file.extension
 	// 3. folders/file (if you want to use this, make sure to mark fileHasNoExtension = true!)
 	bool createFolder(const std::filesystem::path& path, bool fileHasNoExtension = false);
+	bool createFolder(const std::filesystem::path& path, bool fileHasNoExtension, std::error_code& ec) noexcept;
+
+	// the write functions (writeStringToFile() and friends) remember the folders they've already made sure exist (up to
+	// a few thousand of them, by absolute path), so writing a bunch of files into the same folders doesn't stat every
+	// part of the path every time. they notice a folder that's gone missing since and make it again, so the cache
+	// never has to be told about deletes. createFolder() itself always asks the file system. forgetFolder() drops a
+	// folder and everything inside of it, which saves the write functions a failed open() if you know it's gone.
+	struct FolderCacheStats
+	{
+		uint64_t hits{ 0 };
+		uint64_t misses{ 0 };
+		size_t size{ 0 };
+	};
+	void forgetFolder(const std::filesystem::path& folder);
+	void clearFolderCache();
+	FolderCacheStats folderCacheStats();
 
 	// removes the " (n+)" that i append to file names.
 	std::string unSuffix(const std::string& path);
 	// NOTE this is only public so i can easily test it, so i'm putting it in the helper namespace
 
-	// returns the first unused file name, in the format of "folder/filename (n).extension"
+	// where unSuffix() cuts a path. the path without its suffix is head + tail ("folder/name" + ".txt"). if there's no
+	// suffix, head is the whole path and tail is empty. both point into the path that was split, so nothing gets copied
+	struct SuffixSplit
+	{
+		std::string_view head;
+		std::string_view tail;
+		// what was between the parens
+		std::string_view digits;
+		bool found{ false };
+	};
+
+	constexpr SuffixSplit splitSuffix(std::string_view path)
+	{
+		auto isSpace{ [](char c) { return c == ' ' || (c >= '\t' && c <= '\r'); } };
+
+		SuffixSplit split{ path, {}, {}, false };
+
+		size_t endIdx{ path.find_last_of(')') };
+		if (endIdx == std::string_view::npos) {
+			return split;
+		}
+		size_t beginIdx{ path.find_last_of('(', endIdx) };
+		if (beginIdx == std::string_view::npos) {
+			return split;
+		}
+
+		// only digits between the parens, and nothing but whitespace between ')' and the extension. same rules as
+		// unSuffix() has always had
+		for (size_t i{ beginIdx + 1 }; i < endIdx; i++) {
+			if (path[i] < '0' || path[i] > '9') {
+				return split;
+			}
+		}
+		for (size_t i{ endIdx + 1 }; i < path.size() && path[i] != '.'; i++) {
+			if (!isSpace(path[i])) {
+				return split;
+			}
+		}
+
+		// gobble up the spaces on both sides
+		size_t headEnd{ beginIdx };
+		while (headEnd > 0 && path[headEnd - 1] == ' ') {
+			headEnd--;
+		}
+		size_t tailBegin{ endIdx + 1 };
+		while (tailBegin < path.size() && path[tailBegin] == ' ') {
+			tailBegin++;
+		}
+
+		// don't leave a blank file name
+		if (headEnd == 0 && tailBegin == path.size()) {
+			return split;
+		}
+
+		split.head = path.substr(0, headEnd);
+		split.tail = path.substr(tailBegin);
+		split.digits = path.substr(beginIdx + 1, endIdx - beginIdx - 1);
+		split.found = true;
+		return split;
+	}
+
+	// where the file name part of path starts, so path.substr(fileNameStart(path)) is what path::filename() would give
+	constexpr size_t fileNameStart(std::string_view path)
+	{
+#ifdef _WIN32
+		size_t separator{ path.find_last_of("/\\") };
+#else
+		size_t separator{ path.find_last_of('/') };
+#endif
+		return separator == std::string_view::npos ? 0 : separator + 1;
+	}
+
+	// what path::extension() would give, without making a path
+	constexpr std::string_view extensionOf(std::string_view path)
+	{
+		std::string_view fileName{ path.substr(fileNameStart(path)) };
+		if (fileName == "..") {
+			return {};
+		}
+		size_t dot{ fileName.find_last_of('.') };
+		if (dot == std::string_view::npos || dot == 0) {
+			return {};
+		}
+		return fileName.substr(dot);
+	}
+
+	// the longest " (n)" there is
+	inline constexpr size_t maxSuffixLength{ 13 };
+
+	// the buffer versions of unSuffix(), getFirstUnusedFileName()'s "name (n).ext", and renamePath(). they write into
+	// buffer instead of allocating, which is the whole point when you're trying a few hundred names in a row. the view
+	// they return points into buffer, and there's a '\0' after it if there's room, so it can go straight to a system
+	// call. if it doesn't fit, they return an empty view.
+
+	constexpr std::string_view writeInto(std::span<char> buffer, std::initializer_list<std::string_view> parts)
+	{
+		size_t size{ 0 };
+		for (std::string_view part : parts) {
+			size += part.size();
+		}
+		if (size > buffer.size()) {
+			return {};
+		}
+
+		size_t at{ 0 };
+		for (std::string_view part : parts) {
+			for (char c : part) {
+				buffer[at++] = c;
+			}
+		}
+		if (at < buffer.size()) {
+			buffer[at] = '\0';
+		}
+		return { buffer.data(), size };
+	}
+
+	// the whole path again when there's no suffix
+	constexpr std::string_view unSuffix(std::string_view path, std::span<char> buffer)
+	{
+		SuffixSplit split{ splitSuffix(path) };
+		return writeInto(buffer, { split.head, split.tail });
+	}
+
+	// "folder/name (n).ext" from "folder/name.ext". n == 1 is just basicPath. to always fit, buffer needs
+	// basicPath.size() + maxSuffixLength + 1
+	constexpr std::string_view withSuffix(std::string_view basicPath, unsigned int n, std::span<char> buffer)
+	{
+		if (n == 1) {
+			return writeInto(buffer, { basicPath });
+		}
+
+		char digits[10]{};
+		size_t digitCount{ 0 };
+		for (unsigned int left{ n }; left > 0 || digitCount == 0; left /= 10) {
+			digits[sizeof(digits) - ++digitCount] = static_cast<char>('0' + left % 10);
+		}
+
+		std::string_view extension{ extensionOf(basicPath) };
+		std::string_view stem{ basicPath.substr(0, basicPath.size() - extension.size()) };
+		return writeInto(buffer, { stem, " (", { digits + sizeof(digits) - digitCount, digitCount }, ")", extension });
+	}
+
+	constexpr std::string_view renamePath(std::string_view path, std::string_view newName, std::span<char> buffer)
+	{
+		return writeInto(buffer, { path.substr(0, fileNameStart(path)), newName, extensionOf(path) });
+	}
+
+	// returns the first unused file name, in the format of "folder/filename (n).extension". if all 1M of them are
+	// taken, the error is errc::file_exists
 	std::filesystem::path getFirstUnusedFileName(const std::filesystem::path& path);
+	std::filesystem::path getFirstUnusedFileName(const std::filesystem::path& path, std::error_code& ec) noexcept;
+
+	// how copyFileContents() actually moved the bytes, from fastest to slowest
+	enum class CopyStrategy
+	{
+		Reflink,        // FICLONE. the new file shares the old one's blocks (btrfs, xfs), so it's instant
+		CopyFileRange,  // copy_file_range(). stays in the kernel, and some file systems/nfs do it server side
+		Sendfile,       // sendfile(). also stays in the kernel
+		Buffered,       // plain read()/write() loop
+		Filesystem,     // handed off to std::filesystem::copy() (windows, or the source isn't a regular file)
+	};
+
+	// copies from to a brand new file at to, trying the fastest way first and falling back down the list. fails (throws
+	// filesystem_error) if to already exists, just like std::filesystem::copy()
+	CopyStrategy copyFileContents(const std::filesystem::path& from, const std::filesystem::path& to);
+	CopyStrategy copyFileContents(const std::filesystem::path& from, const std::filesystem::path& to, std::error_code& ec) noexcept;
+
+	// like getFirstUnusedFileName(), but it actually claims the name by creating an empty file there (O_CREAT | O_EXCL),
+	// so no other thread or process can end up with the same one. threads in this process reserving names from the same
+	// family at the same time split the numbers up between themselves, instead of all racing for the same one. throws
+	// filesystem_error if the file can't be created for any reason other than the name already being taken.
+	std::filesystem::path reserveUnusedFileName(const std::filesystem::path& path);
+	std::filesystem::path reserveUnusedFileName(const std::filesystem::path& path, std::error_code& ec) noexcept;
+
+	// remembers which " (n)" suffixes are taken in a single folder. it reads the folder once, and from then on unused
+	// names are handed out from memory, so getting N names costs one folder scan instead of a pile of exists() calls.
+	//
+	// names it hands out are marked as taken, even if you never create the file. it can't see files that other code
+	// creates or deletes in the folder afterwards, so call rescan() if you need it to catch up, or tell it about them
+	// with addFileName()/removeFileName(). (FileOperations::WatchedFolder does that for you)
+	class UnusedNameIndex
+	{
+	public:
+		explicit UnusedNameIndex(const std::filesystem::path& folder);
+		// an empty index that isn't tied to a folder. fill it in with addFileName()
+		UnusedNameIndex() = default;
+
+		// same as FileOpHelpers::getFirstUnusedFileName(), but path has to be inside of this index's folder
+		std::filesystem::path getFirstUnusedFileName(const std::filesystem::path& path);
+		std::filesystem::path getFirstUnusedFileName(const std::filesystem::path& path, std::error_code& ec) noexcept;
+
+		// forget everything and read the folder again
+		void rescan();
+		// forget everything, and don't read the folder. for filling it back up with addFileName()
+		void clear();
+
+		// fileName is just the name, not a path. a name that isn't part of a family (or isn't in the index) is ignored
+		void addFileName(const std::string& fileName);
+		void removeFileName(const std::string& fileName);
+
+		const std::filesystem::path& folder() const { return m_folder; }
+
+	private:
+		// every file that unSuffix()'s to the same name. n == 1 stands for the unsuffixed name itself
+		struct Family
+		{
+			std::unordered_set<unsigned int> used;
+			// lowest n that might be free. everything below it is taken
+			unsigned int firstFree{ 1 };
+		};
+
+		// which family fileName belongs in, and its n. 0 if it doesn't count toward any family
+		static unsigned int familyNumber(const std::string& fileName, std::string& basicName);
+
+		std::filesystem::path m_folder;
+		std::unordered_map<std::string, Family> m_families;
+	};
+
+	// same as above, but looks names up in the index instead of hitting the file system
+	std::filesystem::path getFirstUnusedFileName(const std::filesystem::path& path, UnusedNameIndex& index);
+	std::filesystem::path getFirstUnusedFileName(const std::filesystem::path& path, UnusedNameIndex& index, std::error_code& ec) noexcept;
+
+	// the writing half of the large write mode (see LargeWriteOptions). lives in the .cpp, since it's all threads and
+	// system calls
+	class LargeWriter;
+
+	// what the range version of writeStringsToFile() writes through. every line gets formatted onto the end of one
+	// buffer, which is written out whenever it fills up and then reused, so a line never costs an allocation of its own
+	// and memory use stays the same however many lines there are
+	class LineWriter
+	{
+	public:
+		// opens path (creating its folders) the same way writeStringsToFile() does
+		LineWriter(const std::filesystem::path& path, std::ios_base::openmode mode, std::error_code& ec) noexcept;
+		// same, but the buffer goes out through a LargeWriter
+		LineWriter(const std::filesystem::path& path, std::ios_base::openmode mode, const FileOperations::LargeWriteOptions& options, std::error_code& ec) noexcept;
+		// closes the file without writing out what's left, if close() never got called
+		~LineWriter();
+
+		LineWriter(const LineWriter&) = delete;
+		LineWriter& operator=(const LineWriter&) = delete;
+
+		// where the current line goes. it's what std::format_to() takes
+		std::back_insert_iterator<std::string> out() { return std::back_inserter(m_buffer); }
+
+		// puts the '\n' on the current line, and writes the buffer out once there's enough in it
+		bool endLine(std::error_code& ec) noexcept
+		{
+			m_buffer.push_back('\n');
+			return m_buffer.size() < flushSize || flush(ec);
+		}
+
+		// writes out whatever's left and closes the file
+		bool close(std::error_code& ec) noexcept;
+
+	private:
+		static constexpr size_t flushSize{ 1 << 20 };
+
+		bool flush(std::error_code& ec) noexcept;
+		bool writeOut(std::string_view data, std::error_code& ec) noexcept;
+		void finish(bool ok) noexcept;
+
+		std::string m_buffer;
+#ifdef _WIN32
+		std::ofstream m_file;
+#else
+		int m_fd{ -1 };
+#endif
+		std::unique_ptr<LargeWriter> m_large;
+		uint64_t m_written{ 0 };
+		std::chrono::steady_clock::time_point m_start;
+	};
+
+	// what the error_code overloads report when something threw anyway: a system_error's own code,
+	// errc::not_enough_memory for bad_alloc, and errc::invalid_argument for anything else (like a throwing format
+	// callback). only call it from inside of a catch block
+	inline std::error_code currentExceptionError() noexcept
+	{
+		try {
+			throw;
+		}
+		catch (const std::system_error& e) {
+			return e.code();
+		}
+		catch (const std::bad_alloc&) {
+			return std::make_error_code(std::errc::not_enough_memory);
+		}
+		catch (...) {
+			return std::make_error_code(std::errc::invalid_argument);
+		}
+	}
+
+	// the loop behind the range versions of writeStringsToFile()
+	template <typename Range, typename Format>
+	bool formatLines(LineWriter& writer, Range&& range, Format& format, std::error_code& ec) noexcept
+	{
+		// the writer couldn't open the file
+		if (ec) {
+			return false;
+		}
+
+		try {
+			for (auto&& element : range) {
+				format(writer.out(), std::forward<decltype(element)>(element));
+				if (!writer.endLine(ec)) {
+					return false;
+				}
+			}
+			return writer.close(ec);
+		}
+		catch (...) {
+			ec = currentExceptionError();
+		}
+		return false;
+	}
 }
 
 namespace FileOperations
@@ -32,20 +419,322 @@ namespace FileOperations
 
 	// writes single string to a file
 	bool writeStringToFile(const std::string& string, const std::filesystem::path& path, std::ios_base::openmode mode = std::ios_base::out);
+	bool writeStringToFile(const std::string& string, const std::filesystem::path& path, std::ios_base::openmode mode, std::error_code& ec) noexcept;
+	inline bool writeStringToFile(const std::string& string, const std::filesystem::path& path, std::error_code& ec) noexcept
+	{
+		return writeStringToFile(string, path, std::ios_base::out, ec);
+	}
 
 	// writes vector of strings to file. each string in the vector is automatically put on a new line
 	bool writeStringsToFile(const std::vector<std::string>& strings, const std::filesystem::path& path, std::ios_base::openmode mode = std::ios_base::out);
+	bool writeStringsToFile(const std::vector<std::string>& strings, const std::filesystem::path& path, std::ios_base::openmode mode, std::error_code& ec) noexcept;
+	inline bool writeStringsToFile(const std::vector<std::string>& strings, const std::filesystem::path& path, std::error_code& ec) noexcept
+	{
+		return writeStringsToFile(strings, path, std::ios_base::out, ec);
+	}
+
+	// writeStringsToFile() for anything you can loop over (containers, views, generators), without turning it into a
+	// vector<string> first. format(out, element) writes one line, minus the '\n', through the output iterator out, so
+	// it can hand straight off to std::format_to():
+	//
+	//	FileOperations::writeStringsToFile(rows, [](auto out, const Row& row) { return std::format_to(out, "{},{}", row.id, row.name); }, "rows.csv");
+	//
+	// the file comes out exactly like writeStringsToFile() with a vector of the formatted lines would make it, but
+	// through a LineWriter, so no line gets a string of its own and 50M rows take as much memory as 50. if format (or
+	// the range) throws, the file is left partly written, and ec gets errc::not_enough_memory for bad_alloc
+	// and errc::invalid_argument for anything else
+	template <std::ranges::input_range Range, typename Format>
+		requires std::invocable<Format&, std::back_insert_iterator<std::string>, std::ranges::range_reference_t<Range>>
+	bool writeStringsToFile(Range&& range, Format format, const std::filesystem::path& path, std::ios_base::openmode mode, std::error_code& ec) noexcept
+	{
+		FileOpHelpers::LineWriter writer{ path, mode, ec };
+		return FileOpHelpers::formatLines(writer, std::forward<Range>(range), format, ec);
+	}
+	template <std::ranges::input_range Range, typename Format>
+		requires std::invocable<Format&, std::back_insert_iterator<std::string>, std::ranges::range_reference_t<Range>>
+	bool writeStringsToFile(Range&& range, Format format, const std::filesystem::path& path, std::ios_base::openmode mode = std::ios_base::out)
+	{
+		std::error_code ec;
+		return writeStringsToFile(std::forward<Range>(range), std::move(format), path, mode, ec);
+	}
+	template <std::ranges::input_range Range, typename Format>
+		requires std::invocable<Format&, std::back_insert_iterator<std::string>, std::ranges::range_reference_t<Range>>
+	bool writeStringsToFile(Range&& range, Format format, const std::filesystem::path& path, std::error_code& ec) noexcept
+	{
+		return writeStringsToFile(std::forward<Range>(range), std::move(format), path, std::ios_base::out, ec);
+	}
+
+	// for writing files that are much bigger than what you'd want sitting in the page cache afterwards, like multi GB
+	// exports. plain writes grow the file through the page cache a bit at a time, which fragments it on disk and pushes
+	// everything else on the box out of the cache. in this mode, the space gets reserved up front, the data goes out in
+	// big chunks (one being written while the next one fills up), and none of it stays cached.
+	//
+	// linux only. elsewhere, apple just gets F_NOCACHE, and windows ignores all of it
+	struct LargeWriteOptions
+	{
+		// how big the file is going to end up, if you know. it gets fallocate()'d up front, so the file system can hand
+		// out a few big extents instead of growing the file chunk by chunk. if less gets written, the rest is given
+		// back. 0 means you don't know
+		uint64_t expectedSize{ 0 };
+		// write with O_DIRECT, skipping the page cache completely. file systems that don't do O_DIRECT (tmpfs) and
+		// appends to files that don't end on a 4KB boundary quietly fall back to dropCache instead, and so does the
+		// last bit of the file that isn't a whole 4KB block. that happens even if dropCache is false
+		bool direct{ false };
+		// otherwise, push every chunk to disk once it's written and tell the kernel we won't be reading it again
+		bool dropCache{ true };
+		// how much goes out per write. rounded up to a multiple of 4KB. two of these get allocated
+		size_t chunkSize{ 8 << 20 };
+	};
+
+	// writeStringToFile() in the large write mode. the string (plus the '\n') has to be copied into the chunk buffers,
+	// but that overlaps with writing out the chunk before it
+	bool writeStringToFile(const std::string& string, const std::filesystem::path& path, const LargeWriteOptions& options, std::ios_base::openmode mode = std::ios_base::out);
+	bool writeStringToFile(const std::string& string, const std::filesystem::path& path, const LargeWriteOptions& options, std::ios_base::openmode mode, std::error_code& ec) noexcept;
+
+	// the range version of writeStringsToFile() in the large write mode. format fills one chunk while the one before
+	// it is being written
+	template <std::ranges::input_range Range, typename Format>
+		requires std::invocable<Format&, std::back_insert_iterator<std::string>, std::ranges::range_reference_t<Range>>
+	bool writeStringsToFile(Range&& range, Format format, const std::filesystem::path& path, const LargeWriteOptions& options, std::ios_base::openmode mode, std::error_code& ec) noexcept
+	{
+		FileOpHelpers::LineWriter writer{ path, mode, options, ec };
+		return FileOpHelpers::formatLines(writer, std::forward<Range>(range), format, ec);
+	}
+	template <std::ranges::input_range Range, typename Format>
+		requires std::invocable<Format&, std::back_insert_iterator<std::string>, std::ranges::range_reference_t<Range>>
+	bool writeStringsToFile(Range&& range, Format format, const std::filesystem::path& path, const LargeWriteOptions& options, std::ios_base::openmode mode = std::ios_base::out)
+	{
+		std::error_code ec;
+		return writeStringsToFile(std::forward<Range>(range), std::move(format), path, options, mode, ec);
+	}
+
+	// how hard the atomic writes try to make sure the data survives a crash or power loss
+	enum class Durability
+	{
+		None,      // rename only. a crash can't leave a torn file, but the new contents might not have hit the disk yet
+		DataSync,  // fdatasync() the file before renaming it into place
+		FullSync,  // fsync() the file, rename it, then fsync() the folder so the rename itself is on disk too
+	};
+
+	struct AtomicWriteOptions
+	{
+		Durability durability{ Durability::FullSync };
+		// when lots of threads are doing atomic writes at once, let them share one sync phase. whoever gets there first
+		// syncs everybody that's waiting, and the folder only gets synced once per batch instead of once per file
+		bool groupCommit{ false };
+	};
+
+	// crash safe versions of writeStringToFile()/writeStringsToFile(). the data goes to a temporary file next to path,
+	// gets synced according to options.durability, and is then renamed over path. anyone reading path sees either
+	// the old file or the new one, never half of one. these always replace the whole file, so there's no append mode.
+	bool writeStringToFileAtomic(const std::string& string, const std::filesystem::path& path, const AtomicWriteOptions& options = {});
+	bool writeStringsToFileAtomic(const std::vector<std::string>& strings, const std::filesystem::path& path, const AtomicWriteOptions& options = {});
+	bool writeStringToFileAtomic(const std::string& string, const std::filesystem::path& path, const AtomicWriteOptions& options, std::error_code& ec) noexcept;
+	bool writeStringsToFileAtomic(const std::vector<std::string>& strings, const std::filesystem::path& path, const AtomicWriteOptions& options, std::error_code& ec) noexcept;
+
+	// read only view of a whole file. regular files get memory mapped, so nothing is copied until you touch it. pipes,
+	// devices, and things like /proc files that lie about their size get read into a buffer instead. move only, and the
+	// mapping goes away with it, so don't let any views outlive it.
+	class FileContents
+	{
+	public:
+		FileContents() = default;
+		~FileContents();
+
+		FileContents(FileContents&& other) noexcept;
+		FileContents& operator=(FileContents&& other) noexcept;
+		FileContents(const FileContents&) = delete;
+		FileContents& operator=(const FileContents&) = delete;
+
+		std::string_view view() const { return m_map ? std::string_view{ m_map, m_size } : std::string_view{ m_buffer }; }
+		size_t size() const { return view().size(); }
+		bool isMapped() const { return m_map != nullptr; }
+
+	private:
+		friend FileContents readFile(const std::filesystem::path& path, std::error_code& ec) noexcept;
+
+		void release();
+
+		const char* m_map{ nullptr };
+		size_t m_size{ 0 };
+		std::string m_buffer;
+	};
+
+	// throws filesystem_error if the file can't be opened
+	FileContents readFile(const std::filesystem::path& path);
+	// gives back an empty FileContents if it fails
+	FileContents readFile(const std::filesystem::path& path, std::error_code& ec) noexcept;
+
+	// what readLines() and LineReader do with a '\r' right before a '\n'
+	enum class CarriageReturns
+	{
+		// "\r\n" ends a line the same as "\n". that's what writeStringsToFile() writes on windows (text mode), but a
+		// line that really ends in '\r' loses it
+		Strip,
+		// only the '\n' gets taken off, so every line comes back byte for byte. the exact inverse of
+		// writeStringsToFile() on posix
+		Keep,
+	};
+
+	// splits the file back into the strings that writeStringsToFile() wrote. the views point into contents, so no line
+	// gets its own allocation. by default a "\r\n" ending (windows text mode) is treated the same as "\n", so strings
+	// that end in '\r' only survive the round trip with CarriageReturns::Keep
+	std::vector<std::string_view> readLines(const FileContents& contents, CarriageReturns carriageReturns = CarriageReturns::Strip);
+
+	// reads a file a buffer at a time and hands back the lines in batches, for files that are too big to read (or map)
+	// all at once. the newline search uses sse2/avx2 when the cpu has it. lines that straddle two buffers get stitched
+	// back together, and a line longer than the whole buffer just makes the buffer grow. same '\r' handling as
+	// readLines().
+	//
+	//	FileOperations::LineReader reader{ "huge.log" };
+	//	std::vector<std::string_view> lines;
+	//	while (reader.nextBatch(lines)) { ... }
+	class LineReader
+	{
+	public:
+		// throws filesystem_error if the file can't be opened
+		explicit LineReader(const std::filesystem::path& path, size_t bufferSize = 1 << 20, CarriageReturns carriageReturns = CarriageReturns::Strip);
+
+		// replaces lines with the next batch. the views are only good until the next call. returns false once there's
+		// nothing left.
+		bool nextBatch(std::vector<std::string_view>& lines);
+
+	private:
+		std::ifstream m_file;
+		std::vector<char> m_buffer;
+		// m_buffer[m_begin, m_end) is the partial line left over from the last batch
+		size_t m_begin{ 0 };
+		size_t m_end{ 0 };
+		bool m_eof{ false };
+		bool m_stripCarriageReturns;
+	};
 	
+	// lazily walks the files inside of a folder, one entry at a time, so memory use doesn't grow with the size of the
+	// folder. same fileType filter as getAllFilesInFolder(). you can break out of the loop whenever you want.
+	//
+	//	for (const auto& entry : FileOperations::filesInFolder("logs", ".txt")) { ... }
+	class FolderFileRange
+	{
+	public:
+		class Iterator
+		{
+		public:
+			using value_type = std::filesystem::directory_entry;
+			using difference_type = std::ptrdiff_t;
+			using iterator_concept = std::input_iterator_tag;
+
+			Iterator() = default;
+			Iterator(std::filesystem::directory_iterator it, const std::string* fileType, std::error_code* ec = nullptr);
+
+			const std::filesystem::directory_entry& operator*() const { return *m_it; }
+			const std::filesystem::directory_entry* operator->() const { return &*m_it; }
+
+			Iterator& operator++();
+			void operator++(int) { ++*this; }
+
+			bool operator==(std::default_sentinel_t) const { return m_it == std::filesystem::directory_iterator{}; }
+
+		private:
+			// moves forward until we're on a file that passes the filter (or we're at the end)
+			void skipFiltered();
+			// ++m_it, or the error_code version of it. an error ends the walk
+			void advance();
+
+			std::filesystem::directory_iterator m_it;
+			const std::string* m_fileType{ nullptr };
+			// only set for the ec version of filesInFolder()
+			std::error_code* m_ec{ nullptr };
+		};
+
+		FolderFileRange(const std::filesystem::path& path, std::string fileType, std::error_code* ec = nullptr);
+
+		// NOTE this is a single pass range. directory_iterator copies share their position, so only call begin() once
+		Iterator begin() const;
+		std::default_sentinel_t end() const { return {}; }
+
+	private:
+		std::filesystem::path m_path;
+		std::string m_fileType;
+		std::error_code* m_ec{ nullptr };
+	};
+
+	FolderFileRange filesInFolder(const std::filesystem::path& path, const std::string& fileType = "");
+	// if the folder can't be read (or an entry can't be looked at), the loop just ends early and ec says why. ec has to
+	// outlive the loop
+	FolderFileRange filesInFolder(const std::filesystem::path& path, const std::string& fileType, std::error_code& ec) noexcept;
+
 	// returns a list of all files found inside of the folder. has optional fileType filter to only retrieve files with that extension
 	std::vector<std::filesystem::directory_entry> getAllFilesInFolder(const std::filesystem::path& path, const std::string& fileType = "");
+	std::vector<std::filesystem::directory_entry> getAllFilesInFolder(const std::filesystem::path& path, const std::string& fileType, std::error_code& ec) noexcept;
+	inline std::vector<std::filesystem::directory_entry> getAllFilesInFolder(const std::filesystem::path& path, std::error_code& ec) noexcept
+	{
+		return getAllFilesInFolder(path, "", ec);
+	}
+
+	struct RecursiveOptions
+	{
+		// same filter as getAllFilesInFolder(). empty means every file
+		std::string fileType;
+		// how many folders deep to go. 0 only looks at files directly inside of the folder, -1 means no limit
+		int maxDepth{ -1 };
+		// if false, symlinks are reported as files and never walked into
+		bool followSymlinks{ false };
+		// 0 means use every core
+		unsigned int threadCount{ 0 };
+	};
+
+	// recursive version of getAllFilesInFolder(). sub folders get spread across a work stealing thread pool, and on
+	// posix it uses the file type straight out of readdir() so it doesn't have to stat every entry. returns plain paths
+	// instead of directory_entries, since making a directory_entry stats the file, which is what we're trying to avoid.
+	// the order of the results is not deterministic. throws if the top folder can't be read, but quietly skips any sub
+	// folders it isn't allowed into.
+	std::vector<std::filesystem::path> getAllFilesInFolderRecursive(const std::filesystem::path& path, const RecursiveOptions& options = {});
+	std::vector<std::filesystem::path> getAllFilesInFolderRecursive(const std::filesystem::path& path, const RecursiveOptions& options, std::error_code& ec) noexcept;
+
+	// same walk, but calls onFile for every file instead of collecting them. NOTE onFile gets called from multiple
+	// threads at the same time, so it has to be thread safe. the throwing version passes on whatever onFile throws. the
+	// ec version turns it into an error code instead (errc::not_enough_memory for bad_alloc, the code of a
+	// system_error, and errc::invalid_argument for anything else)
+	void forEachFileRecursive(const std::filesystem::path& path, const std::function<void(const std::filesystem::path&)>& onFile, const RecursiveOptions& options = {});
+	void forEachFileRecursive(const std::filesystem::path& path, const std::function<void(const std::filesystem::path&)>& onFile, const RecursiveOptions& options, std::error_code& ec) noexcept;
 
 	// newName should *not* include file extension. aborts if something with that name already exists. returns if file
 	// was successfully renamed. 
+	// the ec version sets errc::invalid_argument if newName has an illegal char, and errc::file_exists if the name is
+	// taken. the other one returns false for those two, and throws for anything else
 	bool renameFile(const std::filesystem::path& current, const std::string& newName);
-	void copyFile(const std::filesystem::path& path);
+	bool renameFile(const std::filesystem::path& current, const std::string& newName, std::error_code& ec) noexcept;
+
+	struct CopyResult
+	{
+		// the name getFirstUnusedFileName() picked for the copy
+		std::filesystem::path destination;
+		FileOpHelpers::CopyStrategy strategy;
+	};
+
+	// makes a copy next to the original, named "file (n).extension". the ec versions give back an empty destination if
+	// they fail
+	CopyResult copyFile(const std::filesystem::path& path);
+	CopyResult copyFile(const std::filesystem::path& path, std::error_code& ec) noexcept;
+	// use this one when making a bunch of copies in the same folder, so the folder only gets read once
+	CopyResult copyFile(const std::filesystem::path& path, FileOpHelpers::UnusedNameIndex& index);
+	CopyResult copyFile(const std::filesystem::path& path, FileOpHelpers::UnusedNameIndex& index, std::error_code& ec) noexcept;
+
+	// returns false if there was nothing to delete
 	bool deleteFile(const std::filesystem::path& path);
+	bool deleteFile(const std::filesystem::path& path, std::error_code& ec) noexcept;
 
-	// windows functions
+	// moves path to the recycle bin on windows. everywhere else it goes in the freedesktop.org trash (what gnome, kde,
+	// etc. all use): the trash in your home folder if path is on the same file system, or a .Trash-$uid folder at the
+	// top of path's own mount if not. either way it's a rename, so even a huge folder takes no time, and it fails
+	// instead of ever copying anything across file systems. (not supported on mac)
 	bool sendToRecycleBin(const std::filesystem::path& path);
+	bool sendToRecycleBin(const std::filesystem::path& path, std::error_code& ec) noexcept;
+	// trashes a whole batch. each trash folder only gets looked up and opened once for the batch. returns the result
+	// for each path, in the same order (an empty error_code means it worked)
+	std::vector<std::error_code> sendToRecycleBin(std::span<const std::filesystem::path> paths);
+
+	// opens path in explorer on windows, or with xdg-open (open on mac) everywhere else
 	bool openInExplorer(const std::filesystem::path& path);
+	bool openInExplorer(const std::filesystem::path& path, std::error_code& ec) noexcept;
 }
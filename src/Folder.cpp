@@ -0,0 +1,355 @@
+#include <cerrno>
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+
+#include "Folder.h"
+#include "PosixIO.h"
+
+#ifndef _WIN32
+namespace
+{
+#ifdef O_PATH
+	// O_PATH is all the *at() calls need, and it doesn't even require read permission on the folder
+	constexpr int folderOpenFlags{ O_PATH | O_DIRECTORY | O_CLOEXEC };
+#else
+	constexpr int folderOpenFlags{ O_RDONLY | O_DIRECTORY | O_CLOEXEC };
+#endif
+
+	// rename that fails with EEXIST instead of replacing something
+	int renameNoReplace(int dirFd, const char* from, const char* to)
+	{
+#if defined(__linux__) && defined(SYS_renameat2)
+		// RENAME_NOREPLACE. glibc only got a wrapper for renameat2() in 2.28, so call it directly
+		if (syscall(SYS_renameat2, dirFd, from, dirFd, to, 1u) == 0) {
+			return 0;
+		}
+		if (errno != EINVAL && errno != ENOSYS) {
+			return -1;
+		}
+#endif
+		// the file system doesn't do RENAME_NOREPLACE. a hard link can't replace anything either, so link the new name
+		// and then drop the old one. (that only works for files, which is all renameFile() is meant for)
+		if (linkat(dirFd, from, dirFd, to, 0) != 0) {
+			return -1;
+		}
+		return unlinkat(dirFd, from, 0);
+	}
+}
+#endif
+
+FileOperations::Folder::Folder(const std::filesystem::path& path)
+	: m_path{ path }
+{
+#ifndef _WIN32
+	m_fd = open(path.c_str(), folderOpenFlags);
+	if (m_fd < 0) {
+		throw std::filesystem::filesystem_error("cannot open folder", path, std::error_code(errno, std::generic_category()));
+	}
+#else
+	if (!std::filesystem::is_directory(path)) {
+		throw std::filesystem::filesystem_error("cannot open folder", path, std::make_error_code(std::errc::not_a_directory));
+	}
+#endif
+}
+
+FileOperations::Folder::~Folder()
+{
+#ifndef _WIN32
+	if (m_fd >= 0) {
+		close(m_fd);
+	}
+#endif
+}
+
+FileOperations::Folder::Folder(Folder&& other) noexcept
+	: m_path{ std::move(other.m_path) }, m_fd{ std::exchange(other.m_fd, -1) }
+{
+}
+
+FileOperations::Folder& FileOperations::Folder::operator=(Folder&& other) noexcept
+{
+	if (this != &other) {
+#ifndef _WIN32
+		if (m_fd >= 0) {
+			close(m_fd);
+		}
+#endif
+		m_path = std::move(other.m_path);
+		m_fd = std::exchange(other.m_fd, -1);
+	}
+	return *this;
+}
+
+bool FileOperations::Folder::exists(const std::string& name, std::error_code& ec) const noexcept
+{
+	try {
+		ec.clear();
+#ifndef _WIN32
+		// don't follow symlinks. a dangling one still takes up the name
+		struct stat st;
+		if (fstatat(m_fd, name.c_str(), &st, AT_SYMLINK_NOFOLLOW) == 0) {
+			return true;
+		}
+		if (errno != ENOENT) {
+			ec = FileOpHelpers::posix::lastError();
+		}
+		return false;
+#else
+		return std::filesystem::exists(m_path / name, ec);
+#endif
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+	}
+	return false;
+}
+
+bool FileOperations::Folder::renameFile(const std::string& currentName, const std::string& newName)
+{
+	std::error_code ec;
+	if (renameFile(currentName, newName, ec)) {
+		return true;
+	}
+
+	// same as the path version. a bad or taken name is just a false
+	if (ec != std::errc::invalid_argument && ec != std::errc::file_exists) {
+		throw std::filesystem::filesystem_error("cannot rename", m_path / currentName, m_path / FileOpHelpers::renamePath(currentName, newName), ec);
+	}
+	return false;
+}
+
+bool FileOperations::Folder::renameFile(const std::string& currentName, const std::string& newName, std::error_code& ec) noexcept
+{
+	try {
+#ifdef _WIN32
+		return FileOperations::renameFile(m_path / currentName, newName, ec);
+#else
+		ec.clear();
+
+		// check if the new name has illegal chars
+		if (FileOpHelpers::filenameHasIllegalChar(newName)) {
+			ec = std::make_error_code(std::errc::invalid_argument);
+			return false;
+		}
+
+		std::string newFileName{ FileOpHelpers::renamePath(currentName, newName).string() };
+
+		// no separate exists() check. the rename itself refuses to replace anything (and fails with EEXIST)
+		if (renameNoReplace(m_fd, currentName.c_str(), newFileName.c_str()) != 0) {
+			ec = FileOpHelpers::posix::lastError();
+			return false;
+		}
+
+		return true;
+#endif
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+	}
+	return false;
+}
+
+bool FileOperations::Folder::deleteFile(const std::string& name)
+{
+	std::error_code ec;
+	bool deleted{ deleteFile(name, ec) };
+	if (ec) {
+		throw std::filesystem::filesystem_error("cannot delete", m_path / name, ec);
+	}
+	return deleted;
+}
+
+bool FileOperations::Folder::deleteFile(const std::string& name, std::error_code& ec) noexcept
+{
+	try {
+#ifdef _WIN32
+		return FileOperations::deleteFile(m_path / name, ec);
+#else
+		ec.clear();
+
+		// std::filesystem::remove() deletes empty folders too, so do the same
+		if (unlinkat(m_fd, name.c_str(), 0) == 0) {
+			return true;
+		}
+		if (errno == EISDIR || errno == EPERM) {
+			if (unlinkat(m_fd, name.c_str(), AT_REMOVEDIR) == 0) {
+				return true;
+			}
+		}
+		// nothing there isn't an error, same as remove()
+		if (errno != ENOENT) {
+			ec = FileOpHelpers::posix::lastError();
+		}
+		return false;
+#endif
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+	}
+	return false;
+}
+
+FileOperations::CopyResult FileOperations::Folder::copyFile(const std::string& name)
+{
+	std::error_code ec;
+	CopyResult result{ copyFile(name, ec) };
+	if (ec) {
+		throw std::filesystem::filesystem_error("cannot copy file", m_path / name, ec);
+	}
+	return result;
+}
+
+FileOperations::CopyResult FileOperations::Folder::copyFile(const std::string& name, std::error_code& ec) noexcept
+{
+	try {
+#ifdef _WIN32
+		return FileOperations::copyFile(m_path / name, ec);
+#else
+		ec.clear();
+
+		FileOpHelpers::posix::FileDescriptor in{ openat(m_fd, name.c_str(), O_RDONLY | O_CLOEXEC) };
+		if (in.fd < 0) {
+			ec = FileOpHelpers::posix::lastError();
+			return {};
+		}
+
+		struct stat st;
+		if (fstat(in.fd, &st) != 0) {
+			ec = FileOpHelpers::posix::lastError();
+			return {};
+		}
+
+		// folders and other odd things keep the std::filesystem behavior
+		if (!S_ISREG(st.st_mode)) {
+			return FileOperations::copyFile(m_path / name, ec);
+		}
+
+		// the O_EXCL create is what claims the name. if someone else got there between the lookup and the create, the
+		// lookup will see their file next time around and move on to the next name
+		std::string newName;
+		FileOpHelpers::posix::FileDescriptor out;
+		do {
+			newName = getFirstUnusedFileName(name, ec);
+			if (ec) {
+				return {};
+			}
+			out.reset(openat(m_fd, newName.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, st.st_mode & 07777));
+		} while (out.fd < 0 && errno == EEXIST);
+
+		if (out.fd < 0) {
+			ec = FileOpHelpers::posix::lastError();
+			return {};
+		}
+
+		FileOpHelpers::CopyStrategy strategy;
+		if (!FileOpHelpers::posix::copyFd(in.fd, out.fd, static_cast<size_t>(st.st_size), strategy) || fchmod(out.fd, st.st_mode & 07777) != 0) {
+			ec = FileOpHelpers::posix::lastError();
+			unlinkat(m_fd, newName.c_str(), 0);
+			return {};
+		}
+
+		return { m_path / newName, strategy };
+#endif
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+	}
+	return {};
+}
+
+bool FileOperations::Folder::writeStringToFile(const std::string& string, const std::string& name, std::ios_base::openmode mode)
+{
+	std::error_code ec;
+	return writeStringToFile(string, name, mode, ec);
+}
+
+bool FileOperations::Folder::writeStringToFile(const std::string& string, const std::string& name, std::ios_base::openmode mode, std::error_code& ec) noexcept
+{
+	try {
+#ifdef _WIN32
+		return FileOperations::writeStringToFile(string, m_path / name, mode, ec);
+#else
+		ec.clear();
+
+		FileOpHelpers::posix::FileDescriptor fd{ FileOpHelpers::posix::openForWriting(name, mode, m_fd) };
+		if (fd.fd < 0) {
+			ec = FileOpHelpers::posix::lastError();
+			return false;
+		}
+
+		static char newline{ '\n' };
+		iovec iov[2]{ { const_cast<char*>(string.data()), string.size() }, { &newline, 1 } };
+		if (!FileOpHelpers::posix::writeAllV(fd.fd, iov, 2)) {
+			ec = FileOpHelpers::posix::lastError();
+			return false;
+		}
+		return true;
+#endif
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+	}
+	return false;
+}
+
+std::string FileOperations::Folder::getFirstUnusedFileName(const std::string& name)
+{
+	std::error_code ec;
+	std::string unusedName{ getFirstUnusedFileName(name, ec) };
+	if (ec) {
+		throw std::filesystem::filesystem_error("cannot find an unused file name", m_path / name, ec);
+	}
+	return unusedName;
+}
+
+std::string FileOperations::Folder::getFirstUnusedFileName(const std::string& name, std::error_code& ec) noexcept
+{
+	try {
+#ifdef _WIN32
+		return FileOpHelpers::getFirstUnusedFileName(m_path / name, ec).filename().string();
+#else
+		// same idea as the path version, just with fstatat() relative to the folder instead of stat() on a full path.
+		// every candidate goes through the same stack buffer, so only the name we hand back gets allocated
+		if (name.size() > NAME_MAX) {
+			ec.assign(ENAMETOOLONG, std::generic_category());
+			return {};
+		}
+		char basicBuffer[NAME_MAX + 1];
+		char candidate[NAME_MAX + FileOpHelpers::maxSuffixLength + 1];
+		std::string_view basicName{ FileOpHelpers::unSuffix(std::string_view{ name }, basicBuffer) };
+
+		ec.clear();
+		for (unsigned int i{ 1 }; i < 1'000'000; i++) {
+			std::string_view testName{ FileOpHelpers::withSuffix(basicName, i, candidate) };
+
+			// don't follow symlinks, same as exists(). a dangling one still takes up the name
+			struct stat st;
+			if (fstatat(m_fd, testName.data(), &st, AT_SYMLINK_NOFOLLOW) == 0) {
+				continue;
+			}
+			if (errno != ENOENT) {
+				ec = FileOpHelpers::posix::lastError();
+				return {};
+			}
+			return std::string{ testName };
+		}
+
+		// 1M files with the same name
+		ec = std::make_error_code(std::errc::file_exists);
+		return {};
+#endif
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+	}
+	return {};
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <filesystem>
+#include <ios>
+#include <string>
+#include <system_error>
+
+#include "FileOperations.h"
+
+namespace FileOperations
+{
+	// a handle to one open folder. every operation takes a plain file name (not a path) and works relative to the
+	// handle through the *at() syscalls, so the kernel doesn't have to walk the whole path again every time. handy for
+	// deep folders where you're doing thousands of things in the same place.
+	//
+	// renameFile() also closes the gap between "check that the new name is free" and "rename" that the path based
+	// version has, since the check and the rename are a single syscall here.
+	//
+	// on windows this just joins the name onto the folder path and calls the regular functions.
+	class Folder
+	{
+	public:
+		// throws filesystem_error if the folder can't be opened
+		explicit Folder(const std::filesystem::path& path);
+		~Folder();
+
+		Folder(Folder&& other) noexcept;
+		Folder& operator=(Folder&& other) noexcept;
+		Folder(const Folder&) = delete;
+		Folder& operator=(const Folder&) = delete;
+
+		const std::filesystem::path& path() const { return m_path; }
+
+		// every one of these has a non-throwing error_code overload too, same deal as the free functions
+
+		// same rules as FileOperations::renameFile(). newName should *not* include the file extension
+		bool renameFile(const std::string& currentName, const std::string& newName);
+		bool renameFile(const std::string& currentName, const std::string& newName, std::error_code& ec) noexcept;
+
+		// same as FileOperations::deleteFile(). returns false if there was nothing to delete
+		bool deleteFile(const std::string& name);
+		bool deleteFile(const std::string& name, std::error_code& ec) noexcept;
+
+		// same as FileOperations::copyFile(). the copy goes in this folder
+		CopyResult copyFile(const std::string& name);
+		CopyResult copyFile(const std::string& name, std::error_code& ec) noexcept;
+
+		// same as FileOperations::writeStringToFile()
+		bool writeStringToFile(const std::string& string, const std::string& name, std::ios_base::openmode mode = std::ios_base::out);
+		bool writeStringToFile(const std::string& string, const std::string& name, std::ios_base::openmode mode, std::error_code& ec) noexcept;
+		bool writeStringToFile(const std::string& string, const std::string& name, std::error_code& ec) noexcept
+		{
+			return writeStringToFile(string, name, std::ios_base::out, ec);
+		}
+
+		// same as FileOpHelpers::getFirstUnusedFileName(), but it only deals in file names
+		std::string getFirstUnusedFileName(const std::string& name);
+		std::string getFirstUnusedFileName(const std::string& name, std::error_code& ec) noexcept;
+
+	private:
+		bool exists(const std::string& name, std::error_code& ec) const noexcept;
+
+		std::filesystem::path m_path;
+		int m_fd{ -1 };
+	};
+}
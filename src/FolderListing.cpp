@@ -0,0 +1,274 @@
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <numeric>
+#include <utility>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "FileOperations.h"
+#include "FolderListing.h"
+#include "PosixIO.h"
+#include "ThreadPool.h"
+
+namespace
+{
+	bool hasFileType(std::string_view name, const std::string& fileType)
+	{
+		return fileType.empty() || FileOpHelpers::extensionOf(name) == fileType;
+	}
+
+	constexpr uint32_t folderMode{ 0040000 };
+	constexpr uint32_t typeMask{ 0170000 };
+
+#ifndef _WIN32
+	// fills in the metadata for one entry. a mode of 0 means it's gone
+	void statEntry(int folderFd, const char* name, uint64_t& size, int64_t& modifiedTime, uint32_t& mode)
+	{
+#if defined(__linux__) && defined(STATX_SIZE)
+		// only ask for what we keep. on network file systems especially, every field you don't ask for is one less
+		// thing the server has to come up with
+		struct statx st;
+		if (statx(folderFd, name, AT_STATX_SYNC_AS_STAT, STATX_TYPE | STATX_MODE | STATX_SIZE | STATX_MTIME, &st) != 0) {
+			mode = 0;
+			return;
+		}
+		size = st.stx_size;
+		modifiedTime = static_cast<int64_t>(st.stx_mtime.tv_sec) * 1'000'000'000 + st.stx_mtime.tv_nsec;
+		mode = st.stx_mode;
+#else
+		struct stat st;
+		if (fstatat(folderFd, name, &st, 0) != 0) {
+			mode = 0;
+			return;
+		}
+#ifdef __APPLE__
+		const timespec& mtime{ st.st_mtimespec };
+#else
+		const timespec& mtime{ st.st_mtim };
+#endif
+		size = static_cast<uint64_t>(st.st_size);
+		modifiedTime = static_cast<int64_t>(mtime.tv_sec) * 1'000'000'000 + mtime.tv_nsec;
+		mode = static_cast<uint32_t>(st.st_mode);
+#endif
+	}
+#endif
+}
+
+void FileOperations::FolderListing::add(std::string_view name)
+{
+	m_nameOffsets.push_back(static_cast<uint32_t>(m_names.size()));
+	m_nameLengths.push_back(static_cast<uint16_t>(name.size()));
+	// null terminated, so the names can go straight to the *at() calls
+	m_names.append(name);
+	m_names.push_back('\0');
+}
+
+void FileOperations::FolderListing::reorder(const std::vector<uint32_t>& order)
+{
+	auto gather{ [&](auto& column) {
+		std::remove_reference_t<decltype(column)> sorted(column.size());
+		for (size_t i{ 0 }; i < order.size(); i++) {
+			sorted[i] = column[order[i]];
+		}
+		column = std::move(sorted);
+	} };
+
+	// the names themselves stay where they are. only where to find them moves
+	gather(m_nameOffsets);
+	gather(m_nameLengths);
+	gather(m_sizes);
+	gather(m_modifiedTimes);
+	gather(m_modes);
+}
+
+void FileOperations::FolderListing::sort(SortBy by, bool descending)
+{
+	std::vector<uint32_t> order(size());
+	std::iota(order.begin(), order.end(), 0);
+
+	if (by == SortBy::Name) {
+		std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+			return descending ? name(b) < name(a) : name(a) < name(b);
+		});
+	}
+	else {
+		// sort (key, index) pairs instead of indexes, so the comparisons never have to go look anything up. the index
+		// breaks ties, which keeps it stable
+		std::vector<std::pair<int64_t, uint32_t>> keyed(size());
+		for (uint32_t i{ 0 }; i < keyed.size(); i++) {
+			int64_t key{ by == SortBy::Size ? static_cast<int64_t>(m_sizes[i]) : m_modifiedTimes[i] };
+			// ~key flips the order without overflowing like -key could
+			keyed[i] = { descending ? ~key : key, i };
+		}
+		std::sort(keyed.begin(), keyed.end());
+		for (size_t i{ 0 }; i < keyed.size(); i++) {
+			order[i] = keyed[i].second;
+		}
+	}
+
+	reorder(order);
+}
+
+size_t FileOperations::FolderListing::removeUnless(const std::vector<bool>& kept)
+{
+	if (std::find(kept.begin(), kept.end(), false) == kept.end()) {
+		return 0;
+	}
+
+	// the names get packed back together too, so a listing that's been filtered down doesn't hang on to all of them
+	std::string names;
+	size_t out{ 0 };
+	for (size_t i{ 0 }; i < size(); i++) {
+		if (!kept[i]) {
+			continue;
+		}
+		std::string_view entryName{ name(i) };
+		m_nameOffsets[out] = static_cast<uint32_t>(names.size());
+		names.append(entryName);
+		names.push_back('\0');
+		m_nameLengths[out] = m_nameLengths[i];
+		m_sizes[out] = m_sizes[i];
+		m_modifiedTimes[out] = m_modifiedTimes[i];
+		m_modes[out] = m_modes[i];
+		out++;
+	}
+
+	size_t removed{ size() - out };
+	m_names = std::move(names);
+	m_nameOffsets.resize(out);
+	m_nameLengths.resize(out);
+	m_sizes.resize(out);
+	m_modifiedTimes.resize(out);
+	m_modes.resize(out);
+	return removed;
+}
+
+FileOperations::FolderListing FileOperations::listFolder(const std::filesystem::path& path, const ListingOptions& options)
+{
+	std::error_code ec;
+	FolderListing listing{ listFolder(path, options, ec) };
+	if (ec) {
+		throw std::filesystem::filesystem_error("cannot list folder", path, ec);
+	}
+	return listing;
+}
+
+FileOperations::FolderListing FileOperations::listFolder(const std::filesystem::path& path, const ListingOptions& options, std::error_code& ec) noexcept
+{
+	ec.clear();
+
+	try {
+		FolderListing listing;
+		listing.m_folder = path;
+
+#ifdef _WIN32
+		// FindNextFile() hands back the size, time, and attributes with every name, and directory_entry keeps them, so
+		// none of this costs an extra call
+		std::filesystem::directory_iterator it{ path, ec };
+		for (; !ec && it != std::filesystem::directory_iterator{}; it.increment(ec)) {
+			std::filesystem::file_status status{ it->status(ec) };
+			if (ec) {
+				break;
+			}
+			bool isFolder{ std::filesystem::is_directory(status) };
+			std::string name{ it->path().filename().string() };
+			if (isFolder ? !options.includeFolders : !hasFileType(name, options.fileType)) {
+				continue;
+			}
+
+			listing.add(name);
+			listing.m_sizes.push_back(isFolder ? 0 : it->file_size(ec));
+			auto modified{ std::chrono::clock_cast<std::chrono::system_clock>(it->last_write_time(ec)) };
+			listing.m_modifiedTimes.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(modified.time_since_epoch()).count());
+			listing.m_modes.push_back((isFolder ? folderMode : 0100000) | static_cast<uint32_t>(status.permissions() & std::filesystem::perms::mask));
+			if (ec) {
+				break;
+			}
+		}
+		if (ec) {
+			return {};
+		}
+#else
+		std::unique_ptr<DIR, int (*)(DIR*)> dir{ opendir(path.c_str()), closedir };
+		if (!dir) {
+			ec = FileOpHelpers::posix::lastError();
+			return {};
+		}
+
+		// names first. whatever the file type rules out never gets stat'd
+		while (true) {
+			errno = 0;
+			dirent* entry{ readdir(dir.get()) };
+			if (!entry) {
+				if (errno != 0) {
+					ec = FileOpHelpers::posix::lastError();
+					return {};
+				}
+				break;
+			}
+
+			std::string_view name{ entry->d_name };
+			if (name == "." || name == "..") {
+				continue;
+			}
+
+			// symlinks (and file systems that don't fill in d_type) could turn out to be folders either way
+			bool maybeFolder{ entry->d_type == DT_DIR || entry->d_type == DT_LNK || entry->d_type == DT_UNKNOWN };
+			if (entry->d_type == DT_DIR && !options.includeFolders) {
+				continue;
+			}
+			if (!hasFileType(name, options.fileType) && !(maybeFolder && options.includeFolders)) {
+				continue;
+			}
+
+			listing.add(name);
+		}
+
+		size_t count{ listing.m_nameOffsets.size() };
+		listing.m_sizes.resize(count);
+		listing.m_modifiedTimes.resize(count);
+		listing.m_modes.resize(count);
+
+		int folderFd{ dirfd(dir.get()) };
+		auto statOne{ [&](size_t i) {
+			statEntry(folderFd, listing.m_names.data() + listing.m_nameOffsets[i], listing.m_sizes[i], listing.m_modifiedTimes[i], listing.m_modes[i]);
+		} };
+
+		if (count >= options.parallelThreshold) {
+			FileOpHelpers::ThreadPool pool{ options.threadCount };
+			FileOpHelpers::parallelFor(pool, count, statOne);
+		}
+		else {
+			for (size_t i{ 0 }; i < count; i++) {
+				statOne(i);
+			}
+		}
+
+		// now that the symlinks are resolved, drop the folders we didn't want, the files the type filter would've skipped,
+		// and anything that was deleted in the meantime
+		listing.filter([&](size_t i) {
+			uint32_t mode{ listing.m_modes[i] };
+			if (mode == 0) {
+				return false;
+			}
+			if ((mode & typeMask) == folderMode) {
+				return options.includeFolders;
+			}
+			return hasFileType(listing.name(i), options.fileType);
+		});
+#endif
+
+		return listing;
+	}
+	catch (...) {
+		// couldn't start the threads, or ran out of memory
+		ec = FileOpHelpers::currentExceptionError();
+		return {};
+	}
+}
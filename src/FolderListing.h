@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace FileOperations
+{
+	struct ListingOptions
+	{
+		// same filter as getAllFilesInFolder(). empty means every file
+		std::string fileType;
+		// getAllFilesInFolder() leaves folders out. set this to get them too
+		bool includeFolders{ false };
+		// folders with at least this many entries get stat'd on a thread pool. stat'ing is cheap enough that for small
+		// folders, starting the threads would cost more than it saves
+		size_t parallelThreshold{ 4096 };
+		// 0 means use every core
+		unsigned int threadCount{ 0 };
+	};
+
+	// a folder listing with the size, modified time, and mode of everything in it. it's a struct of arrays: all the names
+	// sit back to back in one string, and the sizes, times, and modes each get their own array. so there's no path (and
+	// no heap allocation) per entry, and sorting or filtering by size only has to look at the sizes.
+	//
+	//	FileOperations::FolderListing listing{ FileOperations::listFolder("logs", { .fileType = ".log" }) };
+	//	listing.filter([&](size_t i) { return listing.fileSize(i) > 1'000'000; });
+	//	listing.sort(FileOperations::FolderListing::SortBy::ModifiedTime, true);
+	//	for (size_t i{ 0 }; i < listing.size(); i++) { listing.name(i) ... }
+	class FolderListing
+	{
+	public:
+		enum class SortBy
+		{
+			Name,
+			Size,
+			ModifiedTime,
+		};
+
+		const std::filesystem::path& folder() const { return m_folder; }
+
+		size_t size() const { return m_sizes.size(); }
+		bool empty() const { return m_sizes.empty(); }
+
+		std::string_view name(size_t i) const { return { m_names.data() + m_nameOffsets[i], m_nameLengths[i] }; }
+		// folder() / name(i). this one does allocate
+		std::filesystem::path path(size_t i) const { return m_folder / name(i); }
+		uint64_t fileSize(size_t i) const { return m_sizes[i]; }
+		// nanoseconds since 1970
+		int64_t modifiedTime(size_t i) const { return m_modifiedTimes[i]; }
+		// st_mode style type and permission bits. folders have 0040000 set
+		uint32_t mode(size_t i) const { return m_modes[i]; }
+		bool isFolder(size_t i) const { return (m_modes[i] & 0170000) == 0040000; }
+
+		// the raw columns, for crunching through a whole column at once
+		std::span<const uint64_t> fileSizes() const { return m_sizes; }
+		std::span<const int64_t> modifiedTimes() const { return m_modifiedTimes; }
+		std::span<const uint32_t> modes() const { return m_modes; }
+
+		// entries with the same key keep the order they were in
+		void sort(SortBy by, bool descending = false);
+
+		// keeps only the entries keep(i) returns true for, without changing their order. keep can look at anything in the
+		// listing, since nothing moves until it's been asked about every entry. returns how many got removed
+		template <typename Keep>
+		size_t filter(Keep keep)
+		{
+			std::vector<bool> kept(size());
+			for (size_t i{ 0 }; i < size(); i++) {
+				kept[i] = keep(i);
+			}
+			return removeUnless(kept);
+		}
+
+	private:
+		friend FolderListing listFolder(const std::filesystem::path& path, const ListingOptions& options, std::error_code& ec) noexcept;
+
+		void add(std::string_view name);
+		size_t removeUnless(const std::vector<bool>& kept);
+		// puts every column in order[0], order[1], ... order
+		void reorder(const std::vector<uint32_t>& order);
+
+		std::filesystem::path m_folder;
+		std::string m_names;
+		std::vector<uint32_t> m_nameOffsets;
+		// names are at most 255 bytes on every file system we care about
+		std::vector<uint16_t> m_nameLengths;
+		std::vector<uint64_t> m_sizes;
+		std::vector<int64_t> m_modifiedTimes;
+		std::vector<uint32_t> m_modes;
+	};
+
+	// getAllFilesInFolder(), but with the metadata you'd otherwise stat every entry for afterwards, in a FolderListing.
+	// on linux it's one statx() per entry asking for only those fields, and it skips stat'ing anything the file type
+	// filter rules out. symlinks are followed, same as getAllFilesInFolder(). entries that disappear while it's reading
+	// are left out. throws filesystem_error if the folder can't be read
+	FolderListing listFolder(const std::filesystem::path& path, const ListingOptions& options = {});
+	FolderListing listFolder(const std::filesystem::path& path, const ListingOptions& options, std::error_code& ec) noexcept;
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+// small raii/syscall helpers shared by the posix code paths. not part of the public api.
+
+#ifndef _WIN32
+
+#include <cerrno>
+#include <climits>
+#include <filesystem>
+#include <ios>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace FileOpHelpers
+{
+	enum class CopyStrategy;
+}
+
+namespace FileOpHelpers::posix
+{
+	// closes the file descriptor when it goes out of scope
+	struct FileDescriptor
+	{
+		int fd{ -1 };
+
+		FileDescriptor() = default;
+		explicit FileDescriptor(int fd) : fd{ fd } {}
+		~FileDescriptor() { reset(); }
+
+		FileDescriptor(FileDescriptor&& other) noexcept : fd{ std::exchange(other.fd, -1) } {}
+		FileDescriptor& operator=(FileDescriptor&& other) noexcept
+		{
+			if (this != &other) {
+				reset(std::exchange(other.fd, -1));
+			}
+			return *this;
+		}
+		FileDescriptor(const FileDescriptor&) = delete;
+		FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+		void reset(int newFd = -1)
+		{
+			if (fd >= 0) close(fd);
+			fd = newFd;
+		}
+
+		// hands the fd over to the caller, who is now in charge of closing it
+		int release() { return std::exchange(fd, -1); }
+	};
+
+	inline std::error_code lastError()
+	{
+		return { errno, std::generic_category() };
+	}
+
+	inline bool writeAll(int fd, const char* data, size_t size)
+	{
+		while (size > 0) {
+			ssize_t written{ write(fd, data, size) };
+			if (written < 0) {
+				if (errno == EINTR) continue;
+				return false;
+			}
+			data += written;
+			size -= static_cast<size_t>(written);
+		}
+		return true;
+	}
+
+	// opens path the same way std::ofstream would for this mode (it always adds out). relative paths are looked up
+	// inside of dirFd. returns -1 on failure
+	inline int openForWriting(const std::filesystem::path& path, std::ios_base::openmode mode, int dirFd = AT_FDCWD)
+	{
+		mode |= std::ios_base::out;
+
+		int flags{ O_WRONLY | O_CLOEXEC };
+		if ((mode & std::ios_base::app) && (mode & std::ios_base::trunc)) {
+			// not a valid combination for ofstream either
+			errno = EINVAL;
+			return -1;
+		}
+		else if (mode & std::ios_base::app) {
+			flags |= O_CREAT | O_APPEND;
+		}
+		else if ((mode & std::ios_base::in) && !(mode & std::ios_base::trunc)) {
+			// "r+". file has to exist already, and we write over the start of it without truncating
+		}
+		else {
+			flags |= O_CREAT | O_TRUNC;
+		}
+
+		int fd{ openat(dirFd, path.c_str(), flags, 0666) };
+		if (fd >= 0 && (mode & std::ios_base::ate)) {
+			lseek(fd, 0, SEEK_END);
+		}
+		return fd;
+	}
+
+	// writes every iovec, picking up where the kernel left off after short writes. iov gets modified along the way
+	inline bool writeAllV(int fd, iovec* iov, int count)
+	{
+		while (count > 0) {
+			ssize_t written{ writev(fd, iov, count) };
+			if (written < 0) {
+				if (errno == EINTR) continue;
+				return false;
+			}
+
+			// skip past everything that made it out, and trim the iovec we stopped partway through
+			size_t n{ static_cast<size_t>(written) };
+			while (count > 0 && n >= iov->iov_len) {
+				n -= iov->iov_len;
+				++iov;
+				--count;
+			}
+			if (count > 0) {
+				iov->iov_base = static_cast<char*>(iov->iov_base) + n;
+				iov->iov_len -= n;
+			}
+		}
+		return true;
+	}
+
+	// writes every string plus a '\n' straight from the strings themselves, no copying into a buffer first. each
+	// writev() call covers up to IOV_MAX pieces, so a 10M line vector is ~20k syscalls instead of 10M stream inserts.
+	inline bool writeLines(int fd, const std::vector<std::string>& strings)
+	{
+		static char newline{ '\n' };
+
+		std::vector<iovec> iov;
+		iov.reserve(std::min<size_t>(strings.size() * 2, IOV_MAX));
+
+		for (const std::string& s : strings) {
+			if (!s.empty()) {
+				iov.push_back({ const_cast<char*>(s.data()), s.size() });
+			}
+			iov.push_back({ &newline, 1 });
+
+			if (iov.size() + 2 > IOV_MAX) {
+				if (!writeAllV(fd, iov.data(), static_cast<int>(iov.size()))) {
+					return false;
+				}
+				iov.clear();
+			}
+		}
+
+		return writeAllV(fd, iov.data(), static_cast<int>(iov.size()));
+	}
+
+	// copies size bytes from in to out, which must both be at offset 0. returns false (with errno set) on a real error.
+	// strategies that the file system or kernel doesn't support get skipped, as long as they haven't copied anything yet
+	bool copyFd(int in, int out, size_t size, CopyStrategy& strategy);
+}
+
+#endif
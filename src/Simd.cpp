@@ -0,0 +1,158 @@
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+#include "Simd.h"
+
+// sse2 is only guaranteed on 64 bit x86
+#if defined(__x86_64__) || defined(_M_X64)
+#define FILEOPS_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// msvc lets you use any intrinsic without telling the compiler about it first
+#define FILEOPS_TARGET_AVX2
+#else
+#define FILEOPS_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace
+{
+	// the kernels are templated on Strip so the check doesn't cost anything per line when it's off
+	template <bool Strip>
+	inline void emitLine(const char* begin, const char* end, std::vector<std::string_view>& lines)
+	{
+		// strip the '\r' from "\r\n", so files written in windows text mode come back out the same
+		if (Strip && end > begin && end[-1] == '\r') {
+			--end;
+		}
+		lines.emplace_back(begin, static_cast<size_t>(end - begin));
+	}
+
+	template <bool Strip>
+	size_t splitLinesScalar(const char* data, size_t size, std::vector<std::string_view>& lines)
+	{
+		// memchr is already pretty well optimized by the c library, but it doesn't know how to batch short lines
+		const char* lineBegin{ data };
+		const char* end{ data + size };
+		while (const char* newline{ static_cast<const char*>(std::memchr(lineBegin, '\n', static_cast<size_t>(end - lineBegin))) }) {
+			emitLine<Strip>(lineBegin, newline, lines);
+			lineBegin = newline + 1;
+		}
+		return static_cast<size_t>(lineBegin - data);
+	}
+
+#ifdef FILEOPS_X86
+	// compare a whole block against '\n' at once, turn the result into a bitmask, then walk the set bits. short lines
+	// cost one bit instead of one memchr() call each.
+
+	template <bool Strip>
+	size_t splitLinesSSE2(const char* data, size_t size, std::vector<std::string_view>& lines)
+	{
+		const __m128i newlines{ _mm_set1_epi8('\n') };
+
+		const char* lineBegin{ data };
+		size_t i{ 0 };
+		for (; i + 16 <= size; i += 16) {
+			__m128i block{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)) };
+			uint32_t mask{ static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newlines))) };
+
+			while (mask) {
+				const char* newline{ data + i + std::countr_zero(mask) };
+				emitLine<Strip>(lineBegin, newline, lines);
+				lineBegin = newline + 1;
+				mask &= mask - 1;
+			}
+		}
+
+		// finish the last partial block the slow way
+		size_t used{ static_cast<size_t>(lineBegin - data) };
+		return used + splitLinesScalar<Strip>(data + used, size - used, lines);
+	}
+
+	template <bool Strip>
+	FILEOPS_TARGET_AVX2 size_t splitLinesAVX2(const char* data, size_t size, std::vector<std::string_view>& lines)
+	{
+		const __m256i newlines{ _mm256_set1_epi8('\n') };
+
+		const char* lineBegin{ data };
+		size_t i{ 0 };
+		for (; i + 32 <= size; i += 32) {
+			__m256i block{ _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)) };
+			uint32_t mask{ static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newlines))) };
+
+			while (mask) {
+				const char* newline{ data + i + std::countr_zero(mask) };
+				emitLine<Strip>(lineBegin, newline, lines);
+				lineBegin = newline + 1;
+				mask &= mask - 1;
+			}
+		}
+
+		size_t used{ static_cast<size_t>(lineBegin - data) };
+		return used + splitLinesSSE2<Strip>(data + used, size - used, lines);
+	}
+
+	bool cpuHasAVX2()
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) {
+			return false;
+		}
+		__cpuid(info, 1);
+		// the os has to save the ymm registers too (osxsave + xgetbv), not just the cpu supporting it
+		bool osxsave{ (info[2] & (1 << 27)) != 0 };
+		if (!osxsave || (_xgetbv(0) & 0x6) != 0x6) {
+			return false;
+		}
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+#endif
+}
+
+FileOpHelpers::SimdLevel FileOpHelpers::bestSimdLevel()
+{
+	static const SimdLevel level{ [] {
+#ifdef FILEOPS_X86
+		if (cpuHasAVX2()) {
+			return SimdLevel::AVX2;
+		}
+		return SimdLevel::SSE2;
+#else
+		return SimdLevel::Scalar;
+#endif
+	}() };
+
+	return level;
+}
+
+size_t FileOpHelpers::splitLines(const char* data, size_t size, std::vector<std::string_view>& lines, bool stripCarriageReturns)
+{
+	return splitLines(data, size, lines, bestSimdLevel(), stripCarriageReturns);
+}
+
+size_t FileOpHelpers::splitLines(const char* data, size_t size, std::vector<std::string_view>& lines, SimdLevel level, bool stripCarriageReturns)
+{
+	// never go past what the cpu can actually do, even if someone asks for it
+	if (level > bestSimdLevel()) {
+		level = bestSimdLevel();
+	}
+
+	switch (level) {
+#ifdef FILEOPS_X86
+	case SimdLevel::AVX2:
+		return stripCarriageReturns ? splitLinesAVX2<true>(data, size, lines) : splitLinesAVX2<false>(data, size, lines);
+	case SimdLevel::SSE2:
+		return stripCarriageReturns ? splitLinesSSE2<true>(data, size, lines) : splitLinesSSE2<false>(data, size, lines);
+#endif
+	default:
+		return stripCarriageReturns ? splitLinesScalar<true>(data, size, lines) : splitLinesScalar<false>(data, size, lines);
+	}
+}
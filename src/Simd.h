@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+namespace FileOpHelpers
+{
+	// which vector instructions a kernel should use. the best one this cpu supports gets picked at runtime, but they're
+	// all selectable so the tests can check that they agree with each other.
+	enum class SimdLevel
+	{
+		Scalar,
+		SSE2,
+		AVX2,
+	};
+
+	// best level this cpu supports (checked once)
+	SimdLevel bestSimdLevel();
+
+	// finds every '\n' in data and appends the lines in between to lines (without the '\n', and without a '\r' right
+	// before it unless stripCarriageReturns is false). returns how many bytes were used up, i.e. one past the last '\n'.
+	// anything after that is a partial line that the caller needs to hang on to.
+	size_t splitLines(const char* data, size_t size, std::vector<std::string_view>& lines, bool stripCarriageReturns = true);
+	size_t splitLines(const char* data, size_t size, std::vector<std::string_view>& lines, SimdLevel level, bool stripCarriageReturns = true);
+}
@@ -0,0 +1,282 @@
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Stats.h"
+
+namespace
+{
+	using FileOperations::Stats::Histogram;
+	using FileOperations::Stats::Op;
+	using FileOperations::Stats::OpStats;
+	using FileOperations::Stats::Snapshot;
+
+	constexpr size_t opCount{ static_cast<size_t>(Op::Count) };
+
+	// one thread's numbers. only the thread that owns it ever writes to it, so a relaxed load + store is enough to
+	// bump a counter (no locked instructions), and snapshot() can still read it from another thread safely
+	struct Shard
+	{
+		struct Counters
+		{
+			std::atomic<uint64_t> calls{ 0 };
+			std::atomic<uint64_t> errors{ 0 };
+			std::atomic<uint64_t> bytes{ 0 };
+			std::atomic<uint64_t> totalNanoseconds{ 0 };
+			std::array<std::atomic<uint64_t>, Histogram::bucketCount> latency{};
+		};
+
+		std::array<Counters, opCount> ops;
+
+		static void add(std::atomic<uint64_t>& counter, uint64_t value)
+		{
+			counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		}
+
+		void addTo(Snapshot& snapshot) const
+		{
+			for (size_t i{ 0 }; i < opCount; i++) {
+				const Counters& from{ ops[i] };
+				OpStats& to{ snapshot.ops[i] };
+				to.calls += from.calls.load(std::memory_order_relaxed);
+				to.errors += from.errors.load(std::memory_order_relaxed);
+				to.bytes += from.bytes.load(std::memory_order_relaxed);
+				to.totalNanoseconds += from.totalNanoseconds.load(std::memory_order_relaxed);
+				for (int b{ 0 }; b < Histogram::bucketCount; b++) {
+					to.latency.counts[b] += from.latency[b].load(std::memory_order_relaxed);
+				}
+			}
+		}
+	};
+
+	void subtract(Snapshot& snapshot, const Snapshot& baseline)
+	{
+		for (size_t i{ 0 }; i < opCount; i++) {
+			OpStats& to{ snapshot.ops[i] };
+			const OpStats& from{ baseline.ops[i] };
+			to.calls -= from.calls;
+			to.errors -= from.errors;
+			to.bytes -= from.bytes;
+			to.totalNanoseconds -= from.totalNanoseconds;
+			for (int b{ 0 }; b < Histogram::bucketCount; b++) {
+				to.latency.counts[b] -= from.latency.counts[b];
+			}
+		}
+	}
+
+	// every live shard, plus whatever the threads that already exited left behind
+	class Registry
+	{
+	public:
+		void add(Shard* shard)
+		{
+			std::lock_guard lock{ m_mutex };
+			m_shards.push_back(shard);
+		}
+
+		void remove(Shard* shard)
+		{
+			std::lock_guard lock{ m_mutex };
+			shard->addTo(m_retired);
+			std::erase(m_shards, shard);
+		}
+
+		Snapshot snapshot()
+		{
+			std::lock_guard lock{ m_mutex };
+			Snapshot snapshot{ rawSnapshot() };
+			subtract(snapshot, m_baseline);
+			return snapshot;
+		}
+
+		// counters never go backwards (that would race with the threads writing them), so a reset just remembers
+		// where they were and snapshot() subtracts that
+		void reset()
+		{
+			std::lock_guard lock{ m_mutex };
+			m_baseline = rawSnapshot();
+		}
+
+	private:
+		Snapshot rawSnapshot() const
+		{
+			Snapshot snapshot{ m_retired };
+			for (const Shard* shard : m_shards) {
+				shard->addTo(snapshot);
+			}
+			return snapshot;
+		}
+
+		std::mutex m_mutex;
+		std::vector<Shard*> m_shards;
+		Snapshot m_retired;
+		Snapshot m_baseline;
+	};
+
+	Registry& registry()
+	{
+		static Registry registry;
+		return registry;
+	}
+
+	// ~28KB per thread, which is a lot for thread local storage, so the shard itself lives on the heap
+	struct ShardOwner
+	{
+		std::unique_ptr<Shard> shard{ std::make_unique<Shard>() };
+
+		ShardOwner() { registry().add(shard.get()); }
+		~ShardOwner() { registry().remove(shard.get()); }
+	};
+
+	Shard& localShard()
+	{
+		thread_local ShardOwner owner;
+		return *owner.shard;
+	}
+
+	using Hook = std::function<void(const FileOperations::Stats::Event&)>;
+
+	// checked on every operation, so keep the common "no hook" case down to one load
+	std::atomic<bool> hookSet{ false };
+	std::mutex hookMutex;
+	std::shared_ptr<const Hook> hook;
+}
+
+const char* FileOperations::Stats::opName(Op op)
+{
+	switch (op) {
+	case Op::WriteStringToFile: return "writeStringToFile";
+	case Op::WriteStringsToFile: return "writeStringsToFile";
+	case Op::CopyFile: return "copyFile";
+	case Op::RenameFile: return "renameFile";
+	case Op::DeleteFile: return "deleteFile";
+	case Op::GetAllFilesInFolder: return "getAllFilesInFolder";
+	case Op::Count: break;
+	}
+	return "unknown";
+}
+
+int FileOperations::Stats::Histogram::bucketFor(uint64_t nanoseconds)
+{
+	if (nanoseconds < subBuckets) {
+		return static_cast<int>(nanoseconds);
+	}
+
+	int topBit{ static_cast<int>(std::bit_width(nanoseconds)) - 1 };
+	if (topBit >= maxBits) {
+		return bucketCount - 1;
+	}
+
+	// keep the top subBucketBits + 1 bits. the highest one is always set, so it's the other 4 that pick the sub bucket
+	int shift{ topBit - subBucketBits };
+	return (shift + 1) * subBuckets + static_cast<int>((nanoseconds >> shift) - subBuckets);
+}
+
+uint64_t FileOperations::Stats::Histogram::upperBound(int bucket)
+{
+	if (bucket < subBuckets) {
+		return static_cast<uint64_t>(bucket);
+	}
+
+	int shift{ bucket / subBuckets - 1 };
+	uint64_t lower{ static_cast<uint64_t>(bucket % subBuckets + subBuckets) << shift };
+	return lower + (uint64_t{ 1 } << shift) - 1;
+}
+
+uint64_t FileOperations::Stats::Histogram::total() const
+{
+	uint64_t total{ 0 };
+	for (uint64_t count : counts) {
+		total += count;
+	}
+	return total;
+}
+
+uint64_t FileOperations::Stats::Histogram::percentile(double percentile) const
+{
+	uint64_t total{ this->total() };
+	if (total == 0) {
+		return 0;
+	}
+
+	uint64_t rank{ static_cast<uint64_t>(std::ceil(static_cast<double>(total) * percentile / 100.0)) };
+	rank = std::max<uint64_t>(rank, 1);
+
+	uint64_t seen{ 0 };
+	for (int b{ 0 }; b < bucketCount; b++) {
+		seen += counts[b];
+		if (seen >= rank) {
+			return upperBound(b);
+		}
+	}
+	return upperBound(bucketCount - 1);
+}
+
+FileOperations::Stats::Snapshot FileOperations::Stats::snapshot()
+{
+	return registry().snapshot();
+}
+
+void FileOperations::Stats::reset()
+{
+	registry().reset();
+}
+
+std::string FileOperations::Stats::toJson(const Snapshot& snapshot)
+{
+	std::string json{ "{" };
+
+	for (size_t i{ 0 }; i < opCount; i++) {
+		const OpStats& stats{ snapshot.ops[i] };
+
+		json += std::format("{}\"{}\":{{\"calls\":{},\"errors\":{},\"bytes\":{},\"totalNs\":{},\"p50Ns\":{},\"p90Ns\":{},\"p99Ns\":{},\"p999Ns\":{},\"buckets\":[",
+			i == 0 ? "" : ",", opName(static_cast<Op>(i)), stats.calls, stats.errors, stats.bytes, stats.totalNanoseconds,
+			stats.latency.percentile(50), stats.latency.percentile(90), stats.latency.percentile(99), stats.latency.percentile(99.9));
+
+		bool first{ true };
+		for (int b{ 0 }; b < Histogram::bucketCount; b++) {
+			if (stats.latency.counts[b] == 0) {
+				continue;
+			}
+			json += std::format("{}[{},{}]", first ? "" : ",", Histogram::upperBound(b), stats.latency.counts[b]);
+			first = false;
+		}
+
+		json += "]}";
+	}
+
+	json += "}";
+	return json;
+}
+
+void FileOperations::Stats::setHook(std::function<void(const Event&)> newHook)
+{
+	std::lock_guard lock{ hookMutex };
+	hook = newHook ? std::make_shared<const Hook>(std::move(newHook)) : nullptr;
+	hookSet.store(hook != nullptr, std::memory_order_release);
+}
+
+void FileOpHelpers::stats::record(FileOperations::Stats::Op op, uint64_t nanoseconds, uint64_t bytes, bool ok)
+{
+	Shard::Counters& counters{ localShard().ops[static_cast<size_t>(op)] };
+	Shard::add(counters.calls, 1);
+	Shard::add(counters.errors, ok ? 0 : 1);
+	Shard::add(counters.bytes, bytes);
+	Shard::add(counters.totalNanoseconds, nanoseconds);
+	Shard::add(counters.latency[Histogram::bucketFor(nanoseconds)], 1);
+
+	if (hookSet.load(std::memory_order_acquire)) {
+		std::shared_ptr<const Hook> current;
+		{
+			std::lock_guard lock{ hookMutex };
+			current = hook;
+		}
+		if (current) {
+			(*current)({ op, nanoseconds, bytes, ok });
+		}
+	}
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <system_error>
+
+// per operation call counts, bytes, errors, and latency histograms, for finding out which file operations are eating
+// your time. it's off unless the library gets built with FILEOPERATIONS_STATS defined (cmake -DFILEOPERATIONS_STATS=ON).
+// when it's off, the recording code compiles down to nothing, and snapshot() just comes back empty.
+//
+// every thread records into its own shard, so recording never takes a lock. snapshot() adds the shards together.
+//
+//	auto stats{ FileOperations::Stats::snapshot() };
+//	auto& copies{ stats[FileOperations::Stats::Op::CopyFile] };
+//	std::cout << copies.calls << " copies, p99 " << copies.latency.percentile(99) << "ns\n";
+
+namespace FileOperations::Stats
+{
+#ifdef FILEOPERATIONS_STATS
+	inline constexpr bool enabled{ true };
+#else
+	inline constexpr bool enabled{ false };
+#endif
+
+	enum class Op : uint8_t
+	{
+		WriteStringToFile,
+		WriteStringsToFile,
+		CopyFile,
+		RenameFile,
+		DeleteFile,
+		GetAllFilesInFolder,
+		Count,
+	};
+
+	// "copyFile" etc.
+	const char* opName(Op op);
+
+	// hdr style histogram of nanoseconds. values under 16 get their own bucket, and every power of two above that is
+	// split into 16 buckets, so any value is off by at most 1/16th (~6%) no matter how big it is. goes up to ~18 minutes.
+	struct Histogram
+	{
+		static constexpr int subBucketBits{ 4 };
+		static constexpr int subBuckets{ 1 << subBucketBits };
+		static constexpr int maxBits{ 40 };
+		static constexpr int bucketCount{ (maxBits - subBucketBits + 1) * subBuckets };
+
+		std::array<uint64_t, bucketCount> counts{};
+
+		static int bucketFor(uint64_t nanoseconds);
+		// the biggest value that lands in bucket
+		static uint64_t upperBound(int bucket);
+
+		uint64_t total() const;
+		// percentile is 0-100. returns the upper bound of the bucket it falls in, or 0 if there's nothing recorded
+		uint64_t percentile(double percentile) const;
+	};
+
+	struct OpStats
+	{
+		uint64_t calls{ 0 };
+		uint64_t errors{ 0 };
+		uint64_t bytes{ 0 };
+		uint64_t totalNanoseconds{ 0 };
+		Histogram latency;
+	};
+
+	struct Snapshot
+	{
+		std::array<OpStats, static_cast<size_t>(Op::Count)> ops{};
+
+		OpStats& operator[](Op op) { return ops[static_cast<size_t>(op)]; }
+		const OpStats& operator[](Op op) const { return ops[static_cast<size_t>(op)]; }
+	};
+
+	// everything recorded since the start (or the last reset()), from every thread
+	Snapshot snapshot();
+	void reset();
+
+	// the snapshot as json, with counts, percentiles, and the non-empty histogram buckets as [upperBoundNs, count]
+	// pairs so it can be merged with other snapshots later
+	std::string toJson(const Snapshot& snapshot);
+
+	// for feeding your own metrics system. the hook gets called right after every operation finishes, on whatever
+	// thread did the operation, so it has to be thread safe and should be quick. pass nullptr to remove it.
+	struct Event
+	{
+		Op op;
+		uint64_t nanoseconds;
+		uint64_t bytes;
+		bool ok;
+	};
+	void setHook(std::function<void(const Event&)> hook);
+}
+
+namespace FileOpHelpers::stats
+{
+	// NOTE this is how the library records things. it's only in here so the inline no-op versions are visible
+
+	void record(FileOperations::Stats::Op op, uint64_t nanoseconds, uint64_t bytes, bool ok);
+
+	// times one operation from construction to destruction. give it the operation's error_code and it works out
+	// whether it failed by itself, whichever return it leaves through
+	class ScopedOp
+	{
+	public:
+		explicit ScopedOp(FileOperations::Stats::Op op) : m_op{ op }
+		{
+			if constexpr (FileOperations::Stats::enabled) {
+				m_start = std::chrono::steady_clock::now();
+			}
+		}
+
+		ScopedOp(FileOperations::Stats::Op op, const std::error_code& ec) : ScopedOp{ op }
+		{
+			m_ec = &ec;
+		}
+
+		~ScopedOp()
+		{
+			if constexpr (FileOperations::Stats::enabled) {
+				auto elapsed{ std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start) };
+				record(m_op, static_cast<uint64_t>(elapsed.count()), m_bytes, m_ok && !(m_ec && *m_ec));
+			}
+		}
+
+		ScopedOp(const ScopedOp&) = delete;
+		ScopedOp& operator=(const ScopedOp&) = delete;
+
+		void addBytes(uint64_t bytes) { m_bytes += bytes; }
+		// for the ones that don't have an error_code to watch
+		void setOk(bool ok) { m_ok = ok; }
+
+	private:
+		FileOperations::Stats::Op m_op;
+		std::chrono::steady_clock::time_point m_start;
+		const std::error_code* m_ec{ nullptr };
+		uint64_t m_bytes{ 0 };
+		bool m_ok{ true };
+	};
+}
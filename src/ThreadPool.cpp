@@ -0,0 +1,172 @@
+#include "ThreadPool.h"
+
+namespace
+{
+	// lets submit() know if it's being called from one of our own workers, so it can use that worker's queue
+	thread_local const FileOpHelpers::ThreadPool* t_pool{ nullptr };
+	thread_local int t_workerIdx{ -1 };
+}
+
+FileOpHelpers::ThreadPool::ThreadPool(unsigned int threadCount)
+{
+	if (threadCount == 0) {
+		threadCount = std::thread::hardware_concurrency();
+	}
+	// hardware_concurrency() is allowed to return 0 if it can't tell
+	if (threadCount == 0) {
+		threadCount = 1;
+	}
+
+	for (unsigned int i{ 0 }; i < threadCount; ++i) {
+		m_queues.push_back(std::make_unique<WorkerQueue>());
+	}
+	try {
+		m_threads.reserve(threadCount);
+		for (unsigned int i{ 0 }; i < threadCount; ++i) {
+			m_threads.emplace_back(&ThreadPool::workerLoop, this, i);
+		}
+	}
+	catch (...) {
+		// the ones that did start have to be joined, or destroying them takes the whole program down
+		stop();
+		throw;
+	}
+}
+
+FileOpHelpers::ThreadPool::~ThreadPool()
+{
+	stop();
+}
+
+void FileOpHelpers::ThreadPool::stop()
+{
+	{
+		std::lock_guard lock{ m_mutex };
+		m_stopping = true;
+	}
+	m_workAvailable.notify_all();
+
+	for (std::thread& t : m_threads) {
+		t.join();
+	}
+	m_threads.clear();
+}
+
+int FileOpHelpers::ThreadPool::currentWorker() const
+{
+	return t_pool == this ? t_workerIdx : -1;
+}
+
+void FileOpHelpers::ThreadPool::submit(std::function<void()> task)
+{
+	int worker{ currentWorker() };
+	unsigned int idx{ worker >= 0
+		? static_cast<unsigned int>(worker)
+		: m_nextQueue.fetch_add(1, std::memory_order_relaxed) % threadCount() };
+
+	// count it before it's visible in a queue, otherwise a worker could grab it and decrement first
+	m_pending.fetch_add(1);
+	m_queued.fetch_add(1);
+
+	{
+		std::lock_guard lock{ m_queues[idx]->mutex };
+		m_queues[idx]->tasks.push_back(std::move(task));
+	}
+
+	// nobody asleep means everybody will look through the queues again before they go to sleep. otherwise go through
+	// m_mutex, so the worker is either still before its last check of m_queued (and sees this task), or already waiting
+	// (and gets woken up)
+	if (m_sleeping.load() > 0) {
+		{
+			std::lock_guard lock{ m_mutex };
+		}
+		m_workAvailable.notify_one();
+	}
+}
+
+void FileOpHelpers::ThreadPool::wait()
+{
+	std::unique_lock lock{ m_mutex };
+	m_allDone.wait(lock, [this] { return m_pending == 0; });
+
+	if (m_exception) {
+		std::exception_ptr e{ m_exception };
+		m_exception = nullptr;
+		std::rethrow_exception(e);
+	}
+}
+
+bool FileOpHelpers::ThreadPool::tryPop(unsigned int idx, std::function<void()>& task)
+{
+	// our own queue is LIFO, so a depth first walk keeps working on what it just found (warm caches, small queues)
+	WorkerQueue& q{ *m_queues[idx] };
+	std::lock_guard lock{ q.mutex };
+	if (q.tasks.empty()) {
+		return false;
+	}
+
+	task = std::move(q.tasks.back());
+	q.tasks.pop_back();
+	return true;
+}
+
+bool FileOpHelpers::ThreadPool::trySteal(unsigned int thief, std::function<void()>& task)
+{
+	// steal from the front, which is the oldest (and for a folder walk, usually the biggest) piece of work
+	unsigned int n{ threadCount() };
+	for (unsigned int i{ 1 }; i < n; ++i) {
+		WorkerQueue& q{ *m_queues[(thief + i) % n] };
+		std::lock_guard lock{ q.mutex };
+		if (!q.tasks.empty()) {
+			task = std::move(q.tasks.front());
+			q.tasks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+void FileOpHelpers::ThreadPool::run(std::function<void()>& task)
+{
+	try {
+		task();
+	}
+	catch (...) {
+		std::lock_guard lock{ m_mutex };
+		if (!m_exception) {
+			m_exception = std::current_exception();
+		}
+	}
+	task = nullptr;
+
+	// only the last one out wakes up wait(). same lock dance as submit(), so wait() can't miss it
+	if (m_pending.fetch_sub(1) == 1) {
+		{
+			std::lock_guard lock{ m_mutex };
+		}
+		m_allDone.notify_all();
+	}
+}
+
+void FileOpHelpers::ThreadPool::workerLoop(unsigned int idx)
+{
+	t_pool = this;
+	t_workerIdx = static_cast<int>(idx);
+
+	std::function<void()> task;
+	while (true) {
+		if (tryPop(idx, task) || trySteal(idx, task)) {
+			m_queued.fetch_sub(1);
+			run(task);
+			continue;
+		}
+
+		std::unique_lock lock{ m_mutex };
+		m_sleeping.fetch_add(1);
+		m_workAvailable.wait(lock, [this] { return m_stopping || m_queued.load() > 0; });
+		m_sleeping.fetch_sub(1);
+		if (m_stopping && m_queued.load() == 0) {
+			return;
+		}
+	}
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace FileOpHelpers
+{
+	// small work stealing thread pool for the parallel file operations. every worker has its own queue. tasks submitted
+	// from inside of a task go on that worker's own queue (so a folder walk stays mostly local), and idle workers steal
+	// from the front of everyone else's queue.
+	class ThreadPool
+	{
+	public:
+		// threadCount of 0 means use every core
+		explicit ThreadPool(unsigned int threadCount = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		void submit(std::function<void()> task);
+
+		// blocks until every submitted task (and everything those tasks submitted) is done. rethrows the first exception
+		// a task threw, if any.
+		void wait();
+
+		unsigned int threadCount() const { return static_cast<unsigned int>(m_queues.size()); }
+
+		// index of the worker calling this, or -1 if it's not one of our threads
+		int currentWorker() const;
+
+	private:
+		struct WorkerQueue
+		{
+			std::mutex mutex;
+			std::deque<std::function<void()>> tasks;
+		};
+
+		// tells every worker to finish up and joins them
+		void stop();
+		void workerLoop(unsigned int idx);
+		bool tryPop(unsigned int idx, std::function<void()>& task);
+		bool trySteal(unsigned int thief, std::function<void()>& task);
+		void run(std::function<void()>& task);
+
+		// built before any thread starts and never resized, so it doubles as the thread count
+		std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+		std::vector<std::thread> m_threads;
+
+		// the counts are atomic, so a task going through the pool only ever takes its queue's lock. m_mutex is just for
+		// sleeping and waking: a worker bumps m_sleeping before it checks m_queued one last time and goes to sleep, and
+		// submit() only takes m_mutex (so its wake up can't slip in between that check and the sleep) when somebody is
+		// actually asleep
+		std::mutex m_mutex;
+		std::condition_variable m_workAvailable;
+		std::condition_variable m_allDone;
+		std::atomic<size_t> m_queued{ 0 };
+		std::atomic<size_t> m_pending{ 0 }; // queued + currently running
+		std::atomic<unsigned int> m_sleeping{ 0 };
+		bool m_stopping{ false };
+
+		std::exception_ptr m_exception;
+		std::atomic<unsigned int> m_nextQueue{ 0 };
+	};
+
+	// runs work(i) for every i in [0, count) on the pool and waits for all of it, a chunk at a time so tiny tasks don't
+	// drown in overhead
+	template <typename Work>
+	void parallelFor(ThreadPool& pool, size_t count, const Work& work)
+	{
+		size_t chunk{ std::max<size_t>(1, count / (pool.threadCount() * 8)) };
+		for (size_t begin{ 0 }; begin < count; begin += chunk) {
+			size_t end{ std::min(count, begin + chunk) };
+			pool.submit([begin, end, &work] {
+				for (size_t i{ begin }; i < end; i++) {
+					work(i);
+				}
+			});
+		}
+		pool.wait();
+	}
+}
@@ -0,0 +1,362 @@
+#include <cerrno>
+#include <ctime>
+#include <format>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "FileOperations.h"
+#include "PosixIO.h"
+
+#ifdef _WIN32
+bool FileOperations::sendToRecycleBin(const std::filesystem::path& path, std::error_code& ec) noexcept
+{
+	try {
+		// i guess std::filesystem doesn't support this? so i have to use winapi
+
+		// https://stackoverflow.com/questions/70257751/move-a-file-or-folder-to-the-recyclebin-trash-c17
+
+		// std::filesystem doesn't require canonical paths. it works find with relative paths.
+		//
+		// BUT windows is different, so always make sure it's a canonical path. that way we can support relative paths
+		// as well as using '/' (when windows actually requires '\\'). canonical() will convert for us. (it also fails
+		// if the file doesn't exist, which takes care of checking that)
+		std::string pathStr{ std::filesystem::canonical(path, ec).string() };
+		if (ec) {
+			return false;
+		}
+
+		// it requires strings to be double null terminated
+		pathStr += '\0';
+
+		// https://learn.microsoft.com/en-us/windows/win32/api/shellapi/ns-shellapi-shfileopstructa
+		SHFILEOPSTRUCTA fileOp;
+		fileOp.hwnd = NULL;
+		fileOp.wFunc = FO_DELETE;
+		fileOp.pFrom = pathStr.data();
+		fileOp.pTo = NULL;
+		fileOp.fFlags = FOF_ALLOWUNDO | FOF_NOCONFIRMATION;
+
+		// https://learn.microsoft.com/en-us/windows/win32/api/shellapi/nf-shellapi-shfileoperationa
+		int result{ SHFileOperationA(&fileOp) };
+
+		if (result != 0) {
+			ec.assign(result, std::system_category());
+			return false;
+		}
+		// TODO figure out how to get descriptive error messages. some of SHFileOperation()'s codes aren't system errors
+
+		return true;
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+	}
+	return false;
+}
+
+std::vector<std::error_code> FileOperations::sendToRecycleBin(std::span<const std::filesystem::path> paths)
+{
+	std::vector<std::error_code> errors(paths.size());
+	for (size_t i{ 0 }; i < paths.size(); i++) {
+		sendToRecycleBin(paths[i], errors[i]);
+	}
+	return errors;
+}
+#elif defined(__APPLE__)
+// the finder's trash isn't the freedesktop one, and moving things into ~/.Trash by hand skips the "put back" info that
+// finder keeps
+bool FileOperations::sendToRecycleBin(const std::filesystem::path&, std::error_code& ec) noexcept
+{
+	ec = std::make_error_code(std::errc::operation_not_supported);
+	return false;
+}
+
+std::vector<std::error_code> FileOperations::sendToRecycleBin(std::span<const std::filesystem::path> paths)
+{
+	return std::vector<std::error_code>(paths.size(), std::make_error_code(std::errc::operation_not_supported));
+}
+#else
+namespace
+{
+	// https://specifications.freedesktop.org/trash-spec/latest/
+	//
+	// a trash folder has files/ (the trashed things themselves) and info/ (a .trashinfo file for each one, saying where
+	// it came from and when). things only ever get renamed into the trash folder on their own file system, so trashing
+	// is a rename no matter how big the file or folder is. there's one trash in the user's home, and each other mount
+	// gets its own at the top of it.
+	struct TrashCan
+	{
+		std::error_code error;
+		// Path= in the .trashinfo is relative to this for the per mount trashes, and absolute for the home one
+		std::filesystem::path topDir;
+		FileOpHelpers::posix::FileDescriptor files;
+		FileOpHelpers::posix::FileDescriptor info;
+	};
+
+	// mkdir that's fine with the folder already being there, as long as it's really a folder we own and nobody else
+	// can get into. (anybody who could swap it for a symlink could make us trash things into their folder)
+	std::error_code makePrivateFolder(const std::filesystem::path& folder)
+	{
+		if (mkdir(folder.c_str(), 0700) != 0 && errno != EEXIST) {
+			return FileOpHelpers::posix::lastError();
+		}
+
+		struct stat st;
+		if (lstat(folder.c_str(), &st) != 0) {
+			return FileOpHelpers::posix::lastError();
+		}
+		if (!S_ISDIR(st.st_mode) || st.st_uid != getuid()) {
+			return std::make_error_code(std::errc::permission_denied);
+		}
+		return {};
+	}
+
+	std::error_code openTrash(TrashCan& can, const std::filesystem::path& root, dev_t device)
+	{
+		for (const char* sub : { "", "files", "info" }) {
+			if (std::error_code ec{ makePrivateFolder(root / sub) }) {
+				return ec;
+			}
+		}
+
+		can.files.reset(open((root / "files").c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+		can.info.reset(open((root / "info").c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+		if (can.files.fd < 0 || can.info.fd < 0) {
+			return FileOpHelpers::posix::lastError();
+		}
+
+		// something mounted on top of the trash folder would turn our rename into a failure, or worse, a copy
+		struct stat st;
+		if (fstat(can.files.fd, &st) != 0) {
+			return FileOpHelpers::posix::lastError();
+		}
+		if (st.st_dev != device) {
+			return std::make_error_code(std::errc::cross_device_link);
+		}
+		return {};
+	}
+
+	std::filesystem::path homeTrash()
+	{
+		// the spec says relative paths in XDG_DATA_HOME are invalid and should be ignored
+		const char* dataHome{ getenv("XDG_DATA_HOME") };
+		if (dataHome && dataHome[0] == '/') {
+			return std::filesystem::path{ dataHome } / "Trash";
+		}
+
+		const char* home{ getenv("HOME") };
+		if (home && home[0] == '/') {
+			return std::filesystem::path{ home } / ".local/share/Trash";
+		}
+		return {};
+	}
+
+	// the folder at the top of the mount that path lives on. walks up until the device changes
+	std::filesystem::path mountTopDir(const std::filesystem::path& path, dev_t device)
+	{
+		std::filesystem::path dir{ path.parent_path() };
+		while (dir.has_relative_path()) {
+			std::filesystem::path parent{ dir.parent_path() };
+			struct stat st;
+			if (stat(parent.c_str(), &st) != 0 || st.st_dev != device) {
+				break;
+			}
+			dir = parent;
+		}
+		return dir;
+	}
+
+	// Path= is a url style path, so anything outside of the unreserved chars gets %XX'd
+	std::string escapeTrashPath(const std::string& path)
+	{
+		std::string escaped;
+		escaped.reserve(path.size());
+		for (unsigned char c : path) {
+			bool keep{ (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')
+				|| c == '/' || c == '-' || c == '_' || c == '.' || c == '~' || c == '!' || c == '*' || c == '\'' || c == '(' || c == ')' };
+			if (keep) {
+				escaped += static_cast<char>(c);
+			}
+			else {
+				escaped += std::format("%{:02X}", c);
+			}
+		}
+		return escaped;
+	}
+
+	// trashes any number of paths. works out each device's trash folder once and keeps its files/ and info/ folders
+	// open, so a big batch costs about one rename and one small file write per path
+	class Trasher
+	{
+	public:
+		Trasher()
+		{
+			// every file in a batch gets the same deletion date, so only format it once. the spec wants local time
+			std::time_t now{ std::time(nullptr) };
+			std::tm local{};
+			localtime_r(&now, &local);
+			char date[32];
+			std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", &local);
+			m_deletionDate = date;
+		}
+
+		std::error_code trash(const std::filesystem::path& path)
+		{
+			std::error_code ec;
+			std::filesystem::path absolute{ std::filesystem::absolute(path, ec).lexically_normal() };
+			if (ec) {
+				return ec;
+			}
+			// "folder/" should trash the folder
+			if (!absolute.has_filename() && absolute.has_relative_path()) {
+				absolute = absolute.parent_path();
+			}
+
+			// trashing a symlink trashes the link, not what it points at
+			struct stat st;
+			if (lstat(absolute.c_str(), &st) != 0) {
+				return FileOpHelpers::posix::lastError();
+			}
+
+			TrashCan& can{ canFor(absolute, st.st_dev) };
+			if (can.error) {
+				return can.error;
+			}
+
+			std::string trashInfo{ std::format("[Trash Info]\nPath={}\nDeletionDate={}\n",
+				escapeTrashPath(can.topDir.empty() ? absolute.string() : absolute.lexically_relative(can.topDir).string()), m_deletionDate) };
+
+			// both names get built in stack buffers (which always fit a real file name), so going through a lot of taken
+			// ones doesn't allocate
+			std::string name{ absolute.filename().string() };
+			if (name.size() > NAME_MAX) {
+				return std::make_error_code(std::errc::filename_too_long);
+			}
+			char trashBuffer[NAME_MAX + FileOpHelpers::maxSuffixLength + 1];
+			char infoBuffer[sizeof(trashBuffer) + sizeof(".trashinfo")];
+
+			// the spec's way of claiming a name: create the .trashinfo with O_EXCL first, so two programs trashing
+			// things with the same name at the same time can't both pick it
+			for (unsigned int n{ 1 }; n < 1'000'000; n++) {
+				std::string_view trashName{ FileOpHelpers::withSuffix(name, n, trashBuffer) };
+				std::string_view infoName{ FileOpHelpers::writeInto(infoBuffer, { trashName, ".trashinfo" }) };
+
+				FileOpHelpers::posix::FileDescriptor info{ openat(can.info.fd, infoName.data(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600) };
+				if (info.fd < 0) {
+					if (errno == EEXIST) {
+						continue;
+					}
+					return FileOpHelpers::posix::lastError();
+				}
+
+				// a leftover in files/ without its .trashinfo would get clobbered by the rename, so skip those names
+				// too
+				struct stat existing;
+				if (fstatat(can.files.fd, trashName.data(), &existing, AT_SYMLINK_NOFOLLOW) == 0) {
+					unlinkat(can.info.fd, infoName.data(), 0);
+					continue;
+				}
+
+				if (!FileOpHelpers::posix::writeAll(info.fd, trashInfo.data(), trashInfo.size())) {
+					ec = FileOpHelpers::posix::lastError();
+					unlinkat(can.info.fd, infoName.data(), 0);
+					return ec;
+				}
+				info.reset();
+
+				// same file system, so this is a rename even for a huge folder. never a copy
+				if (renameat(AT_FDCWD, absolute.c_str(), can.files.fd, trashName.data()) != 0) {
+					ec = FileOpHelpers::posix::lastError();
+					unlinkat(can.info.fd, infoName.data(), 0);
+					return ec;
+				}
+				return {};
+			}
+
+			return std::make_error_code(std::errc::file_exists);
+		}
+
+	private:
+		TrashCan& canFor(const std::filesystem::path& path, dev_t device)
+		{
+			auto [it, added] { m_cans.try_emplace(device) };
+			TrashCan& can{ it->second };
+			if (!added) {
+				return can;
+			}
+
+			// the home trash, if it's on the same device
+			std::filesystem::path home{ homeTrash() };
+			if (!home.empty()) {
+				std::error_code ec;
+				std::filesystem::create_directories(home.parent_path(), ec);
+				struct stat st;
+				if (!ec && stat(home.parent_path().c_str(), &st) == 0 && st.st_dev == device) {
+					can.error = openTrash(can, home, device);
+					return can;
+				}
+			}
+
+			// else $topdir/.Trash/$uid, but only if an admin set up $topdir/.Trash properly (a real folder with the
+			// sticky bit, so users can't mess with each other's trash)
+			can.topDir = mountTopDir(path, device);
+			std::string uid{ std::to_string(getuid()) };
+
+			struct stat st;
+			std::filesystem::path shared{ can.topDir / ".Trash" };
+			if (lstat(shared.c_str(), &st) == 0 && S_ISDIR(st.st_mode) && (st.st_mode & S_ISVTX)) {
+				can.error = openTrash(can, shared / uid, device);
+				if (!can.error) {
+					return can;
+				}
+			}
+
+			// else $topdir/.Trash-$uid
+			can.error = openTrash(can, can.topDir / (".Trash-" + uid), device);
+			return can;
+		}
+
+		std::map<dev_t, TrashCan> m_cans;
+		std::string m_deletionDate;
+	};
+}
+
+bool FileOperations::sendToRecycleBin(const std::filesystem::path& path, std::error_code& ec) noexcept
+{
+	// building the names and the .trashinfo allocates
+	try {
+		Trasher trasher;
+		ec = trasher.trash(path);
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+	}
+	return !ec;
+}
+
+std::vector<std::error_code> FileOperations::sendToRecycleBin(std::span<const std::filesystem::path> paths)
+{
+	std::vector<std::error_code> errors(paths.size());
+
+	Trasher trasher;
+	for (size_t i{ 0 }; i < paths.size(); i++) {
+		errors[i] = trasher.trash(paths[i]);
+	}
+
+	return errors;
+}
+#endif
+
+bool FileOperations::sendToRecycleBin(const std::filesystem::path& path)
+{
+	std::error_code ec;
+	return sendToRecycleBin(path, ec);
+}
@@ -0,0 +1,284 @@
+#include <cerrno>
+#include <string_view>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "PosixIO.h"
+#include "WatchedFolder.h"
+
+namespace
+{
+#ifdef __linux__
+	constexpr uint32_t watchEvents{ IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR };
+#endif
+}
+
+FileOperations::WatchedFolder::WatchedFolder(const std::filesystem::path& path)
+	: m_path{ path }
+{
+	std::error_code ec;
+#ifdef __linux__
+	m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (m_inotify < 0) {
+		throw std::filesystem::filesystem_error("cannot watch folder", m_path, FileOpHelpers::posix::lastError());
+	}
+#endif
+	rescan(ec);
+	if (ec) {
+#ifdef __linux__
+		close(m_inotify);
+#endif
+		throw std::filesystem::filesystem_error("cannot watch folder", m_path, ec);
+	}
+}
+
+FileOperations::WatchedFolder::~WatchedFolder()
+{
+#ifdef __linux__
+	// closing it drops the watch too
+	close(m_inotify);
+#endif
+}
+
+std::vector<std::filesystem::path> FileOperations::WatchedFolder::getAllFiles(const std::string& fileType)
+{
+	std::error_code ec;
+	std::vector<std::filesystem::path> files{ getAllFiles(fileType, ec) };
+	if (ec) {
+		throw std::filesystem::filesystem_error("cannot list folder", m_path, ec);
+	}
+	return files;
+}
+
+std::vector<std::filesystem::path> FileOperations::WatchedFolder::getAllFiles(const std::string& fileType, std::error_code& ec) noexcept
+{
+	try {
+		std::lock_guard lock{ m_mutex };
+		catchUp(ec);
+		if (ec) {
+			return {};
+		}
+
+		std::vector<std::filesystem::path> files;
+		files.reserve(m_entries.size());
+		for (const auto& [name, isFolder] : m_entries) {
+			if (!isFolder && (fileType.empty() || FileOpHelpers::extensionOf(name) == fileType)) {
+				files.push_back(m_path / name);
+			}
+		}
+		return files;
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+	}
+	return {};
+}
+
+std::vector<std::string> FileOperations::WatchedFolder::getAllFileNames(const std::string& fileType)
+{
+	std::error_code ec;
+	std::vector<std::string> names{ getAllFileNames(fileType, ec) };
+	if (ec) {
+		throw std::filesystem::filesystem_error("cannot list folder", m_path, ec);
+	}
+	return names;
+}
+
+std::vector<std::string> FileOperations::WatchedFolder::getAllFileNames(const std::string& fileType, std::error_code& ec) noexcept
+{
+	try {
+		std::lock_guard lock{ m_mutex };
+		catchUp(ec);
+		if (ec) {
+			return {};
+		}
+
+		std::vector<std::string> names;
+		names.reserve(m_entries.size());
+		for (const auto& [name, isFolder] : m_entries) {
+			if (!isFolder && (fileType.empty() || FileOpHelpers::extensionOf(name) == fileType)) {
+				names.push_back(name);
+			}
+		}
+		return names;
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+	}
+	return {};
+}
+
+bool FileOperations::WatchedFolder::contains(const std::string& name)
+{
+	std::error_code ec;
+	bool found{ contains(name, ec) };
+	if (ec) {
+		throw std::filesystem::filesystem_error("cannot list folder", m_path, ec);
+	}
+	return found;
+}
+
+bool FileOperations::WatchedFolder::contains(const std::string& name, std::error_code& ec) noexcept
+{
+	std::lock_guard lock{ m_mutex };
+	catchUp(ec);
+	return !ec && m_entries.contains(name);
+}
+
+std::filesystem::path FileOperations::WatchedFolder::getFirstUnusedFileName(const std::filesystem::path& path)
+{
+	std::error_code ec;
+	std::filesystem::path unusedPath{ getFirstUnusedFileName(path, ec) };
+	if (ec) {
+		throw std::filesystem::filesystem_error("cannot find an unused file name", path, ec);
+	}
+	return unusedPath;
+}
+
+std::filesystem::path FileOperations::WatchedFolder::getFirstUnusedFileName(const std::filesystem::path& path, std::error_code& ec) noexcept
+{
+	std::lock_guard lock{ m_mutex };
+	catchUp(ec);
+	if (ec) {
+		return {};
+	}
+	return m_names.getFirstUnusedFileName(path, ec);
+}
+
+void FileOperations::WatchedFolder::rescan()
+{
+	std::error_code ec;
+	rescan(ec);
+	if (ec) {
+		throw std::filesystem::filesystem_error("cannot list folder", m_path, ec);
+	}
+}
+
+void FileOperations::WatchedFolder::rescan(std::error_code& ec) noexcept
+{
+	std::lock_guard lock{ m_mutex };
+	m_stale = true;
+	catchUp(ec);
+}
+
+void FileOperations::WatchedFolder::catchUp(std::error_code& ec) noexcept
+{
+	try {
+		ec.clear();
+
+#ifdef __linux__
+		alignas(inotify_event) char buffer[16 * 1024];
+
+		// once we know we're stale, the rest of the queue is useless. it still gets read, just to empty it out
+		while (true) {
+			ssize_t got{ read(m_inotify, buffer, sizeof(buffer)) };
+			if (got < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				if (errno == EAGAIN) {
+					break;
+				}
+				ec = FileOpHelpers::posix::lastError();
+				return;
+			}
+
+			for (char* p{ buffer }; !m_stale && p < buffer + got;) {
+				const inotify_event* event{ reinterpret_cast<const inotify_event*>(p) };
+				p += sizeof(inotify_event) + event->len;
+
+				if (event->mask & IN_Q_OVERFLOW) {
+					m_stale = true;
+				}
+				else if (event->wd != m_watch) {
+					// leftovers from a watch we've already dropped
+				}
+				else if (event->mask & (IN_DELETE_SELF | IN_IGNORED)) {
+					// the kernel drops the watch by itself
+					m_watch = -1;
+					m_stale = true;
+				}
+				else if (event->mask & IN_MOVE_SELF) {
+					// the watch would follow the folder to wherever it went, but we're watching a path
+					inotify_rm_watch(m_inotify, m_watch);
+					m_watch = -1;
+					m_stale = true;
+				}
+				else if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+					// inotify says what the name itself is. a symlink to a folder has to be looked up to count as one
+					bool isFolder{ (event->mask & IN_ISDIR) != 0 };
+					if (!isFolder) {
+						std::error_code ignored;
+						isFolder = std::filesystem::is_directory(m_path / event->name, ignored);
+					}
+					added(event->name, isFolder);
+				}
+				else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+					removed(event->name);
+				}
+			}
+		}
+
+		if (!m_stale) {
+			return;
+		}
+
+		// the watch goes first, so anything that changes while we're reading the folder is already queued up for next
+		// time
+		if (m_watch < 0) {
+			m_watch = inotify_add_watch(m_inotify, m_path.c_str(), watchEvents);
+			if (m_watch < 0) {
+				ec = FileOpHelpers::posix::lastError();
+				return;
+			}
+		}
+#endif
+
+		readFolder(ec);
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+		// some of the events might not have made it in, so read the whole folder again next time
+		m_stale = true;
+	}
+}
+
+void FileOperations::WatchedFolder::readFolder(std::error_code& ec) noexcept
+{
+	try {
+		m_entries.clear();
+		m_names.clear();
+
+		std::filesystem::directory_iterator it{ m_path, ec };
+		for (; !ec && it != std::filesystem::directory_iterator{}; it.increment(ec)) {
+			// follows symlinks, same as getAllFilesInFolder()
+			bool isFolder{ it->is_directory(ec) };
+			if (ec) {
+				break;
+			}
+			added(it->path().filename().string(), isFolder);
+		}
+
+		// leave it stale if that didn't work, so the next call tries again
+		m_stale = static_cast<bool>(ec);
+	}
+	catch (...) {
+		ec = FileOpHelpers::currentExceptionError();
+		m_stale = true;
+	}
+}
+
+void FileOperations::WatchedFolder::added(const std::string& name, bool isFolder)
+{
+	m_entries[name] = isFolder;
+	m_names.addFileName(name);
+}
+
+void FileOperations::WatchedFolder::removed(const std::string& name)
+{
+	m_entries.erase(name);
+	m_names.removeFileName(name);
+}
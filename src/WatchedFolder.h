@@ -0,0 +1,78 @@
+#pragma once
+
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+#include "FileOperations.h"
+
+namespace FileOperations
+{
+	// keeps a folder's listing in memory and up to date, for folders you list over and over. it reads the folder once,
+	// then has the kernel (inotify) tell it about every file that gets created, deleted, or moved in or out, and applies
+	// those before answering anything. so a listing never touches the disk, and it's never out of date either, since
+	// anything that happened before you ask is already waiting in the queue.
+	//
+	// if the kernel's queue overflows (lots of changes and nobody asking for a while), or the folder itself gets deleted
+	// or moved, it falls back to reading the whole folder again.
+	//
+	// it only watches the folder itself, not sub folders. a symlink counts as whatever it pointed at when it showed up.
+	// safe to use from multiple threads. on anything other than linux, every call just reads the folder again.
+	class WatchedFolder
+	{
+	public:
+		// throws filesystem_error if the folder can't be read or watched
+		explicit WatchedFolder(const std::filesystem::path& path);
+		~WatchedFolder();
+
+		WatchedFolder(const WatchedFolder&) = delete;
+		WatchedFolder& operator=(const WatchedFolder&) = delete;
+
+		const std::filesystem::path& path() const { return m_path; }
+
+		// same files as getAllFilesInFolder(path(), fileType), just as paths, and in no particular order
+		std::vector<std::filesystem::path> getAllFiles(const std::string& fileType = "");
+		std::vector<std::filesystem::path> getAllFiles(const std::string& fileType, std::error_code& ec) noexcept;
+
+		// same thing, but only the file names. building a path for every file costs way more than the lookup itself,
+		// so use this one for big folders
+		std::vector<std::string> getAllFileNames(const std::string& fileType = "");
+		std::vector<std::string> getAllFileNames(const std::string& fileType, std::error_code& ec) noexcept;
+
+		// whether there's a file or folder called name in here
+		bool contains(const std::string& name);
+		bool contains(const std::string& name, std::error_code& ec) noexcept;
+
+		// same as FileOpHelpers::getFirstUnusedFileName(), but path has to be inside of this folder. like
+		// UnusedNameIndex, a name it hands out counts as taken until the file gets made and deleted again (or the folder
+		// gets read again), so two threads asking at once don't get the same one
+		std::filesystem::path getFirstUnusedFileName(const std::filesystem::path& path);
+		std::filesystem::path getFirstUnusedFileName(const std::filesystem::path& path, std::error_code& ec) noexcept;
+
+		// throw away everything and read the folder again
+		void rescan();
+		void rescan(std::error_code& ec) noexcept;
+
+	private:
+		// applies whatever the kernel has queued up since last time. m_mutex has to be locked
+		void catchUp(std::error_code& ec) noexcept;
+		void readFolder(std::error_code& ec) noexcept;
+		void added(const std::string& name, bool isFolder);
+		void removed(const std::string& name);
+
+		std::filesystem::path m_path;
+		std::mutex m_mutex;
+
+		// name -> whether it's a folder
+		std::unordered_map<std::string, bool> m_entries;
+		FileOpHelpers::UnusedNameIndex m_names;
+
+		int m_inotify{ -1 };
+		int m_watch{ -1 };
+		// the queue overflowed, or the folder went away. either way, what we have can't be trusted
+		bool m_stale{ false };
+	};
+}